@@ -0,0 +1,131 @@
+/******************************************************************************
+* Compares createChannel for each name with createChannels for all names.
+******************************************************************************/
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+#include <pv/pvDatabase.h>
+#include <pv/channelProviderLocal.h>
+
+using namespace epics::pvData;
+using namespace epics::pvAccess;
+using namespace epics::pvDatabase;
+using std::string;
+using std::vector;
+
+class BenchmarkChannelRequester : public ChannelRequester
+{
+public:
+    POINTER_DEFINITIONS(BenchmarkChannelRequester);
+    virtual ~BenchmarkChannelRequester() {}
+    virtual string getRequesterName() { return "connectBenchmark"; }
+    virtual void channelCreated(
+        const Status& status,
+        Channel::shared_pointer const & channel) {}
+    virtual void channelStateChange(
+        Channel::shared_pointer const & channel,
+        Channel::ConnectionState connectionState) {}
+};
+
+static double now()
+{
+    return epicsMonotonicGet()*1e-9;
+}
+
+static void report(string const & what,size_t number,size_t created,double seconds)
+{
+    std::cout << what << " " << number << " names " << created << " channels "
+              << seconds << " seconds "
+              << (seconds>0.0 ? number/seconds : 0.0) << " names/s\n";
+}
+
+static void connect(
+    ChannelProviderLocalPtr const & provider,
+    ChannelRequester::shared_pointer const & requester,
+    vector<string> const & names,
+    string const & what)
+{
+    vector<Channel::shared_pointer> channels;
+    channels.reserve(names.size());
+    double start = now();
+    size_t created = 0;
+    for(size_t i=0; i<names.size(); ++i) {
+        Channel::shared_pointer channel = provider->createChannel(names[i],requester,0);
+        if(channel) ++created;
+        channels.push_back(channel);
+    }
+    report(what + " createChannel ",names.size(),created,now() - start);
+    channels.clear();
+    start = now();
+    created = provider->createChannels(names,requester,0,channels);
+    report(what + " createChannels",names.size(),created,now() - start);
+}
+
+int main(int argc,char *argv[])
+{
+    size_t numberRecords = 50000;
+    size_t numberMissing = 50000;
+    int opt;
+    while((opt = getopt(argc, argv, "n:m:h")) != -1) {
+        switch(opt) {
+            case 'n':
+               numberRecords = strtoul(optarg,0,10);
+               break;
+            case 'm':
+               numberMissing = strtoul(optarg,0,10);
+               break;
+            case 'h':
+               std::cout << " -n records -m missing -h \n";
+               std::cout << "default\n";
+               std::cout << "-n " << numberRecords << " -m " << numberMissing << "\n";
+               return 0;
+            default:
+                std::cerr<<"Unknown argument: "<<opt<<"\n";
+                return -1;
+        }
+    }
+    PVDatabasePtr master = PVDatabase::getMaster();
+    ChannelProviderLocalPtr provider = getChannelProviderLocal();
+    StructureConstPtr structure = getStandardField()->scalar(pvDouble,"alarm,timeStamp");
+    vector<string> names(numberRecords);
+    double start = now();
+    for(size_t i=0; i<numberRecords; ++i) {
+        std::ostringstream name;
+        name << "bench:" << i;
+        names[i] = name.str();
+        PVRecordPtr pvRecord = PVRecord::create(
+            names[i],getPVDataCreate()->createPVStructure(structure));
+        if(!master->addRecord(pvRecord)) {
+            std::cerr << "could not add " << names[i] << "\n";
+            return -1;
+        }
+    }
+    std::cout << "created " << numberRecords << " records in "
+              << now() - start << " seconds\n";
+    // connect in random order, as a client with a list of names would
+    srand(1);
+    for(size_t i=names.size(); i>1; --i) std::swap(names[i-1],names[rand() % i]);
+    ChannelRequester::shared_pointer requester(new BenchmarkChannelRequester());
+    connect(provider,requester,names,"hosted ");
+    vector<string> missing(numberMissing);
+    for(size_t i=0; i<numberMissing; ++i) {
+        std::ostringstream name;
+        name << "other:" << i;
+        missing[i] = name.str();
+    }
+    connect(provider,requester,missing,"missing");
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t filtered = 0;
+    master->getFindStatistics(hits,misses,filtered);
+    std::cout << "findRecord hits " << hits << " misses " << misses
+              << " filtered " << filtered << "\n";
+    return 0;
+}
@@ -140,7 +140,7 @@ int main (int argc, char** argv)
       ::epics::pvData::FieldBuilderPtr builder = epics::pvData::getFieldCreate()->createFieldBuilder();
       builder->add("value", ::epics::pvData::pvULong);
       std::shared_ptr<::epics::pvData::PVStructure> pvstruct
-          = ::epics::pvData::getPVDataCreate()->createPVStructure(builder->createStructure());
+          = ::epics::pvDatabase::PVRecordPool::getPool()->createPVStructure(builder->createStructure());
       std::shared_ptr<Record> pvrecord = Record::create(std::string(name), pvstruct);
       master->addRecord(pvrecord);
       pvrecord->setTraceLevel(verbose);
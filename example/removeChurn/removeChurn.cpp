@@ -0,0 +1,184 @@
+/******************************************************************************
+* Benchmark for adding and removing records that have many subscribers.
+******************************************************************************/
+#include <iostream>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+#include <epicsGetopt.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsGuard.h>
+
+#include <pv/pvData.h>
+#include <pv/standardPVField.h>
+#include <pv/createRequest.h>
+#include <pv/pvDatabase.h>
+#include <pv/channelProviderLocal.h>
+
+using namespace epics::pvData;
+using namespace epics::pvAccess;
+using namespace epics::pvDatabase;
+using std::tr1::static_pointer_cast;
+using std::string;
+
+class ChurnChannelRequester : public ChannelRequester
+{
+public:
+    POINTER_DEFINITIONS(ChurnChannelRequester);
+    virtual ~ChurnChannelRequester() {}
+    virtual string getRequesterName() { return "removeChurn"; }
+    virtual void channelCreated(
+        const Status& status,
+        Channel::shared_pointer const & channel) {}
+    virtual void channelStateChange(
+        Channel::shared_pointer const & channel,
+        Channel::ConnectionState connectionState) {}
+};
+
+class ChurnMonitorRequester : public MonitorRequester
+{
+public:
+    POINTER_DEFINITIONS(ChurnMonitorRequester);
+    virtual ~ChurnMonitorRequester() {}
+    virtual string getRequesterName() { return "removeChurn"; }
+    virtual void monitorConnect(
+        Status const & status,
+        MonitorPtr const & monitor,
+        StructureConstPtr const & structure) {}
+    virtual void monitorEvent(MonitorPtr const & monitor)
+    {
+        MonitorElementPtr element;
+        while((element = monitor->poll())) monitor->release(element);
+    }
+    virtual void unlisten(MonitorPtr const & monitor) {}
+};
+
+class Lookup : public epicsThreadRunable
+{
+public:
+    Lookup(PVDatabasePtr const & master,string const & recordName)
+    : master(master),
+      recordName(recordName),
+      thread(*this,"lookup",
+          epicsThreadGetStackSize(epicsThreadStackSmall),
+          epicsThreadPriorityMedium),
+      stop(false),
+      maxLatency(0.0),
+      count(0)
+    {
+        thread.start();
+    }
+    virtual void run()
+    {
+        while(true) {
+            {
+                epicsGuard<epics::pvData::Mutex> guard(mutex);
+                if(stop) return;
+            }
+            epicsTime start(epicsTime::getCurrent());
+            master->findRecord(recordName);
+            double latency = epicsTime::getCurrent() - start;
+            epicsGuard<epics::pvData::Mutex> guard(mutex);
+            if(latency>maxLatency) maxLatency = latency;
+            ++count;
+        }
+    }
+    void finish()
+    {
+        {
+            epicsGuard<epics::pvData::Mutex> guard(mutex);
+            stop = true;
+        }
+        thread.exitWait();
+    }
+    double getMaxLatency() { return maxLatency; }
+    size_t getCount() { return count; }
+private:
+    PVDatabasePtr master;
+    string recordName;
+    epicsThread thread;
+    epics::pvData::Mutex mutex;
+    bool stop;
+    double maxLatency;
+    size_t count;
+};
+
+int main(int argc,char *argv[])
+{
+    int cycles = 100;
+    int subscribers = 1000;
+    bool deferred = false;
+    int opt;
+    while((opt = getopt(argc, argv, "c:s:dh")) != -1) {
+        switch(opt) {
+            case 'c':
+               cycles = atoi(optarg);
+               break;
+            case 's':
+               subscribers = atoi(optarg);
+               break;
+            case 'd':
+               deferred = true;
+               break;
+            case 'h':
+               std::cout << " -c cycles -s subscribers -d -h \n";
+               std::cout << "default\n";
+               std::cout << "-c " << cycles << " -s " << subscribers << "\n";
+               return 0;
+            default:
+                std::cerr<<"Unknown argument: "<<opt<<"\n";
+                return -1;
+        }
+    }
+    PVDatabasePtr master = PVDatabase::getMaster();
+    master->setDeferredClientDetach(deferred);
+    ChannelProviderLocalPtr provider = getChannelProviderLocal();
+    StandardPVFieldPtr standardPVField = getStandardPVField();
+    PVRecordPtr target = PVRecord::create(
+        "lookupTarget",standardPVField->scalar(pvDouble,"alarm,timeStamp"));
+    master->addRecord(target);
+    PVStructurePtr pvRequest = CreateRequest::create()->createRequest("field()");
+    ChannelRequester::shared_pointer channelRequester(new ChurnChannelRequester());
+    MonitorRequester::shared_pointer monitorRequester(new ChurnMonitorRequester());
+    Lookup lookup(master,"lookupTarget");
+    double totalRemove = 0.0;
+    double maxRemove = 0.0;
+    epicsTime startAll(epicsTime::getCurrent());
+    for(int cycle=0; cycle<cycles; ++cycle) {
+        std::stringstream ss;
+        ss << "churn" << cycle;
+        string recordName = ss.str();
+        PVRecordPtr pvRecord = PVRecord::create(
+            recordName,standardPVField->scalar(pvDouble,"alarm,timeStamp"));
+        master->addRecord(pvRecord);
+        std::vector<Channel::shared_pointer> channels;
+        std::vector<MonitorPtr> monitors;
+        channels.reserve(subscribers);
+        monitors.reserve(subscribers);
+        for(int i=0; i<subscribers; ++i) {
+            Channel::shared_pointer channel =
+                provider->createChannel(recordName,channelRequester,0);
+            MonitorPtr monitor = channel->createMonitor(monitorRequester,pvRequest);
+            monitor->start();
+            channels.push_back(channel);
+            monitors.push_back(monitor);
+        }
+        epicsTime start(epicsTime::getCurrent());
+        master->removeRecord(pvRecord);
+        double elapsed = epicsTime::getCurrent() - start;
+        totalRemove += elapsed;
+        if(elapsed>maxRemove) maxRemove = elapsed;
+    }
+    double elapsedAll = epicsTime::getCurrent() - startAll;
+    lookup.finish();
+    std::cout << "cycles " << cycles
+              << " subscribers " << subscribers
+              << " deferred " << (deferred ? "true" : "false") << "\n";
+    std::cout << "cycles/second " << cycles/elapsedAll << "\n";
+    std::cout << "removeRecord mean " << (cycles>0 ? totalRemove/cycles : 0.0)*1e6
+              << " us max " << maxRemove*1e6 << " us\n";
+    std::cout << "findRecord calls " << lookup.getCount()
+              << " max latency " << lookup.getMaxLatency()*1e6 << " us\n";
+    return 0;
+}
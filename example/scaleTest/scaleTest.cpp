@@ -0,0 +1,270 @@
+/******************************************************************************
+* Scale test for a PVDatabase with a large number of records.
+******************************************************************************/
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <epicsGetopt.h>
+#include <epicsTime.h>
+#include <epicsAtomic.h>
+#include <epicsGuard.h>
+
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+#include <pv/standardPVField.h>
+#include <pv/createRequest.h>
+#include <pv/pvDatabase.h>
+#include <pv/channelProviderLocal.h>
+
+using namespace epics::pvData;
+using namespace epics::pvAccess;
+using namespace epics::pvDatabase;
+using std::string;
+using std::vector;
+
+class ScaleChannelRequester : public ChannelRequester
+{
+public:
+    POINTER_DEFINITIONS(ScaleChannelRequester);
+    virtual ~ScaleChannelRequester() {}
+    virtual string getRequesterName() { return "scaleTest"; }
+    virtual void channelCreated(
+        const Status& status,
+        Channel::shared_pointer const & channel) {}
+    virtual void channelStateChange(
+        Channel::shared_pointer const & channel,
+        Channel::ConnectionState connectionState) {}
+};
+
+class ScaleMonitorRequester : public MonitorRequester
+{
+public:
+    POINTER_DEFINITIONS(ScaleMonitorRequester);
+    ScaleMonitorRequester() : events(0) {}
+    virtual ~ScaleMonitorRequester() {}
+    virtual string getRequesterName() { return "scaleTest"; }
+    virtual void monitorConnect(
+        Status const & status,
+        MonitorPtr const & monitor,
+        StructureConstPtr const & structure) {}
+    virtual void monitorEvent(MonitorPtr const & monitor)
+    {
+        MonitorElementPtr element;
+        while((element = monitor->poll())) {
+            epicsAtomicIncrSizeT(&events);
+            monitor->release(element);
+        }
+    }
+    virtual void unlisten(MonitorPtr const & monitor) {}
+    size_t events;
+};
+
+// resident set size in bytes
+static size_t getRSS()
+{
+    std::ifstream in("/proc/self/statm");
+    size_t size = 0;
+    size_t resident = 0;
+    in >> size >> resident;
+    return resident*4096;
+}
+
+static double now()
+{
+    return epicsMonotonicGet()*1e-9;
+}
+
+static StructureConstPtr createStructure(string const & kind)
+{
+    StandardFieldPtr standardField = getStandardField();
+    if(kind=="scalar") return standardField->scalar(pvDouble,"alarm,timeStamp");
+    if(kind=="array") return standardField->scalarArray(pvDouble,"alarm,timeStamp");
+    if(kind=="nested") {
+        FieldCreatePtr fieldCreate = getFieldCreate();
+        return fieldCreate->createFieldBuilder()->
+            add("alarm",standardField->alarm()) ->
+            add("timeStamp",standardField->timeStamp()) ->
+            addNestedStructure("power") ->
+               add("value",pvDouble) ->
+               add("alarm",standardField->alarm()) ->
+               endNested()->
+            addNestedStructure("voltage") ->
+               add("value",pvDouble) ->
+               add("alarm",standardField->alarm()) ->
+               endNested()->
+            addNestedStructure("current") ->
+               add("value",pvDouble) ->
+               add("alarm",standardField->alarm()) ->
+               endNested()->
+            createStructure();
+    }
+    return StructureConstPtr();
+}
+
+static void printPercentiles(string const & name,vector<double> & values)
+{
+    if(values.empty()) return;
+    std::sort(values.begin(),values.end());
+    size_t last = values.size()-1;
+    std::cout << name
+              << " p50 " << values[last/2]*1e6
+              << " us p99 " << values[static_cast<size_t>(last*0.99)]*1e6
+              << " us max " << values[last]*1e6 << " us\n";
+}
+
+int main(int argc,char *argv[])
+{
+    int number = 100000;
+    int arraySize = 10;
+    int lookups = 100000;
+    int subscribers = 1000;
+    int puts = 1000;
+    string kinds("scalar,array,nested");
+    int opt;
+    while((opt = getopt(argc, argv, "n:k:a:l:s:p:h")) != -1) {
+        switch(opt) {
+            case 'n':
+               number = atoi(optarg);
+               break;
+            case 'k':
+               kinds = optarg;
+               break;
+            case 'a':
+               arraySize = atoi(optarg);
+               break;
+            case 'l':
+               lookups = atoi(optarg);
+               break;
+            case 's':
+               subscribers = atoi(optarg);
+               break;
+            case 'p':
+               puts = atoi(optarg);
+               break;
+            case 'h':
+               std::cout << " -n records -k kinds -a arraySize -l lookups"
+                         << " -s subscribers -p puts -h \n";
+               std::cout << "kinds is a comma separated list of scalar,array,nested\n";
+               std::cout << "default\n";
+               std::cout << "-n " << number << " -k " << kinds << " -a " << arraySize
+                         << " -l " << lookups << " -s " << subscribers
+                         << " -p " << puts << "\n";
+               return 0;
+            default:
+                std::cerr<<"Unknown argument: "<<opt<<"\n";
+                return -1;
+        }
+    }
+    vector<StructureConstPtr> structures;
+    vector<string> kindNames;
+    std::stringstream kindStream(kinds);
+    string kind;
+    while(std::getline(kindStream,kind,',')) {
+        StructureConstPtr structure = createStructure(kind);
+        if(!structure) {
+            std::cerr << "unknown kind " << kind << "\n";
+            return -1;
+        }
+        structures.push_back(structure);
+        kindNames.push_back(kind);
+    }
+    if(structures.empty() || number<=0) return 0;
+    PVDatabasePtr master = PVDatabase::getMaster();
+    PVDataCreatePtr pvDataCreate = getPVDataCreate();
+    vector<string> names;
+    names.reserve(number);
+
+    size_t rssBefore = getRSS();
+    double start = now();
+    for(int i=0; i<number; ++i) {
+        size_t index = i % structures.size();
+        std::stringstream ss;
+        ss << kindNames[index] << i;
+        PVStructurePtr pvStructure = pvDataCreate->createPVStructure(structures[index]);
+        PVDoubleArrayPtr pvArray = pvStructure->getSubField<PVDoubleArray>("value");
+        if(pvArray) pvArray->setLength(arraySize);
+        PVRecordPtr pvRecord = PVRecord::create(ss.str(),pvStructure);
+        if(!master->addRecord(pvRecord)) {
+            std::cerr << ss.str() << " not added\n";
+            return -1;
+        }
+        names.push_back(ss.str());
+    }
+    double elapsed = now() - start;
+    size_t rssAfter = getRSS();
+    std::cout << "records " << number << " kinds " << kinds << " arraySize " << arraySize << "\n";
+    std::cout << "startup " << elapsed << " s, " << number/elapsed << " records/s\n";
+    std::cout << "RSS " << rssAfter/(1024*1024) << " MB, "
+              << (rssAfter>rssBefore ? (rssAfter-rssBefore)/number : 0) << " bytes/record\n";
+
+    vector<double> latencies;
+    latencies.reserve(lookups);
+    srand(1);
+    for(int i=0; i<lookups; ++i) {
+        string const & name = names[rand() % names.size()];
+        double begin = now();
+        PVRecordPtr pvRecord = master->findRecord(name);
+        latencies.push_back(now() - begin);
+        if(!pvRecord) std::cerr << name << " not found\n";
+    }
+    printPercentiles("findRecord",latencies);
+
+    start = now();
+    PVStringArrayPtr recordNames = master->getRecordNames();
+    elapsed = now() - start;
+    std::cout << "getRecordNames " << recordNames->getLength() << " names "
+              << elapsed*1e3 << " ms\n";
+
+    if(subscribers>0 && puts>0) {
+        string const & name = names[0];
+        ChannelProviderLocalPtr provider = getChannelProviderLocal();
+        ChannelRequester::shared_pointer channelRequester(new ScaleChannelRequester());
+        ScaleMonitorRequester::shared_pointer monitorRequester(new ScaleMonitorRequester());
+        PVStructurePtr pvRequest = CreateRequest::create()->createRequest("field()");
+        Channel::shared_pointer channel = provider->createChannel(name,channelRequester,0);
+        vector<MonitorPtr> monitors;
+        monitors.reserve(subscribers);
+        start = now();
+        for(int i=0; i<subscribers; ++i) {
+            MonitorPtr monitor = channel->createMonitor(monitorRequester,pvRequest);
+            monitor->start();
+            monitors.push_back(monitor);
+        }
+        elapsed = now() - start;
+        std::cout << "monitor create+start " << subscribers << " on " << name << " "
+                  << elapsed*1e6/subscribers << " us/monitor\n";
+        size_t eventsBefore = epicsAtomicGetSizeT(&monitorRequester->events);
+        PVRecordPtr pvRecord = master->findRecord(name);
+        PVFieldPtr pvValue = pvRecord->getPVStructure()->getSubField("value");
+        if(!pvValue) pvValue = pvRecord->getPVStructure()->getSubField("power.value");
+        PVScalarPtr pvScalar = std::tr1::dynamic_pointer_cast<PVScalar>(pvValue);
+        PVDoubleArrayPtr pvArray = std::tr1::dynamic_pointer_cast<PVDoubleArray>(pvValue);
+        latencies.clear();
+        start = now();
+        for(int i=0; i<puts; ++i) {
+            double begin = now();
+            {
+                epicsGuard<PVRecord> guard(*pvRecord);
+                pvRecord->beginGroupPut();
+                if(pvScalar) {
+                    pvScalar->putFrom<double>(i);
+                } else if(pvArray) {
+                    PVDoubleArray::svector value(arraySize,i);
+                    pvArray->replace(freeze(value));
+                }
+                pvRecord->process();
+                pvRecord->endGroupPut();
+            }
+            latencies.push_back(now() - begin);
+        }
+        elapsed = now() - start;
+        size_t events = epicsAtomicGetSizeT(&monitorRequester->events) - eventsBefore;
+        std::cout << "fan-out " << puts << " puts to " << subscribers << " monitors "
+                  << events/elapsed << " events/s\n";
+        printPercentiles("put+notify",latencies);
+    }
+    return 0;
+}
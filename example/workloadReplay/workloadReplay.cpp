@@ -0,0 +1,423 @@
+/******************************************************************************
+* Replays a capture written by WorkloadRecorder through ChannelProviderLocal.
+******************************************************************************/
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <epicsGetopt.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsAtomic.h>
+
+#include <pv/pvData.h>
+#include <pv/json.h>
+#include <pv/createRequest.h>
+#include <pv/pvDatabase.h>
+#include <pv/channelProviderLocal.h>
+#include <pv/workloadRecorder.h>
+
+using namespace epics::pvData;
+using namespace epics::pvAccess;
+using namespace epics::pvDatabase;
+using std::string;
+using std::vector;
+
+class ReplayChannelRequester : public ChannelRequester
+{
+public:
+    POINTER_DEFINITIONS(ReplayChannelRequester);
+    virtual ~ReplayChannelRequester() {}
+    virtual string getRequesterName() { return "workloadReplay"; }
+    virtual void channelCreated(
+        const Status& status,
+        Channel::shared_pointer const & channel) {}
+    virtual void channelStateChange(
+        Channel::shared_pointer const & channel,
+        Channel::ConnectionState connectionState) {}
+};
+
+class ReplayGetRequester : public ChannelGetRequester
+{
+public:
+    POINTER_DEFINITIONS(ReplayGetRequester);
+    virtual ~ReplayGetRequester() {}
+    virtual string getRequesterName() { return "workloadReplay"; }
+    virtual void channelGetConnect(
+        const Status& status,
+        ChannelGet::shared_pointer const & channelGet,
+        StructureConstPtr const & structure) {}
+    virtual void getDone(
+        const Status& status,
+        ChannelGet::shared_pointer const & channelGet,
+        PVStructurePtr const & pvStructure,
+        BitSetPtr const & bitSet) {}
+};
+
+class ReplayPutRequester : public ChannelPutRequester
+{
+public:
+    POINTER_DEFINITIONS(ReplayPutRequester);
+    virtual ~ReplayPutRequester() {}
+    virtual string getRequesterName() { return "workloadReplay"; }
+    virtual void channelPutConnect(
+        const Status& status,
+        ChannelPut::shared_pointer const & channelPut,
+        StructureConstPtr const & structure)
+    {
+        this->structure = structure;
+    }
+    virtual void putDone(
+        const Status& status,
+        ChannelPut::shared_pointer const & channelPut) {}
+    virtual void getDone(
+        const Status& status,
+        ChannelPut::shared_pointer const & channelPut,
+        PVStructurePtr const & pvStructure,
+        BitSetPtr const & bitSet) {}
+    StructureConstPtr structure;
+};
+
+class ReplayProcessRequester : public ChannelProcessRequester
+{
+public:
+    POINTER_DEFINITIONS(ReplayProcessRequester);
+    virtual ~ReplayProcessRequester() {}
+    virtual string getRequesterName() { return "workloadReplay"; }
+    virtual void channelProcessConnect(
+        const Status& status,
+        ChannelProcess::shared_pointer const & channelProcess) {}
+    virtual void processDone(
+        const Status& status,
+        ChannelProcess::shared_pointer const & channelProcess) {}
+};
+
+class ReplayMonitorRequester : public MonitorRequester
+{
+public:
+    POINTER_DEFINITIONS(ReplayMonitorRequester);
+    ReplayMonitorRequester() : events(0) {}
+    virtual ~ReplayMonitorRequester() {}
+    virtual string getRequesterName() { return "workloadReplay"; }
+    virtual void monitorConnect(
+        Status const & status,
+        MonitorPtr const & monitor,
+        StructureConstPtr const & structure) {}
+    virtual void monitorEvent(MonitorPtr const & monitor)
+    {
+        MonitorElementPtr element;
+        while((element = monitor->poll())) {
+            epicsAtomicIncrSizeT(&events);
+            monitor->release(element);
+        }
+    }
+    virtual void unlisten(MonitorPtr const & monitor) {}
+    size_t events;
+};
+
+struct Put {
+    ChannelPut::shared_pointer channelPut;
+    ReplayPutRequester::shared_pointer requester;
+};
+
+typedef vector<vector<double> > Latencies;
+
+// Replays the events of one recorded client in its own thread.
+class Client :
+    public epicsThreadRunable
+{
+public:
+    Client(size_t number)
+    : latencies(WorkloadRecorder::numberOperations),
+      failures(0),
+      provider(getChannelProviderLocal()),
+      channelRequester(new ReplayChannelRequester()),
+      getRequester(new ReplayGetRequester()),
+      processRequester(new ReplayProcessRequester()),
+      monitorRequester(new ReplayMonitorRequester()),
+      speed(1.0),
+      startTime(0),
+      thread(*this,threadName(number).c_str(),
+          epicsThreadGetStackSize(epicsThreadStackMedium),
+          epicsThreadPriorityMedium)
+    {}
+    virtual ~Client() {}
+    void add(WorkloadRecorder::Event const & event) { events.push_back(event);}
+    void start(double speed,uint64 startTime)
+    {
+        this->speed = speed;
+        this->startTime = startTime;
+        thread.start();
+    }
+    void wait() { thread.exitWait();}
+    virtual void run();
+    Latencies latencies;
+    size_t failures;
+    size_t getMonitorEvents() { return epicsAtomicGetSizeT(&monitorRequester->events);}
+private:
+    static string threadName(size_t number)
+    {
+        std::ostringstream name;
+        name << "replayClient" << number;
+        return name.str();
+    }
+    void execute(WorkloadRecorder::Event const & event);
+    Channel::shared_pointer getChannel(string const & channelName);
+    ChannelProviderLocalPtr provider;
+    ChannelRequester::shared_pointer channelRequester;
+    ReplayGetRequester::shared_pointer getRequester;
+    ReplayProcessRequester::shared_pointer processRequester;
+    ReplayMonitorRequester::shared_pointer monitorRequester;
+    vector<WorkloadRecorder::Event> events;
+    std::map<string,Channel::shared_pointer> channels;
+    vector<Channel::shared_pointer> extraChannels;
+    std::map<string,ChannelGet::shared_pointer> gets;
+    std::map<string,Put> puts;
+    std::map<string,ChannelProcess::shared_pointer> processes;
+    vector<MonitorPtr> monitors;
+    double speed;
+    uint64 startTime;
+    epicsThread thread;
+};
+
+static bool createRecord(WorkloadRecorder::Event const & event)
+{
+    StructureConstPtr structure = std::tr1::dynamic_pointer_cast<const Structure>(
+        WorkloadRecorder::stringToField(event.request));
+    if(!structure) {
+        std::cerr << "bad introspection interface for " << event.channelName << "\n";
+        return false;
+    }
+    PVStructurePtr pvStructure = getPVDataCreate()->createPVStructure(structure);
+    std::istringstream in(event.value);
+    try {
+        parseJSON(in,*pvStructure);
+    } catch(std::exception & ex) {
+        std::cerr << event.channelName << " initial value " << ex.what() << "\n";
+    }
+    PVRecordPtr pvRecord = PVRecord::create(event.channelName,pvStructure);
+    return PVDatabase::getMaster()->addRecord(pvRecord);
+}
+
+void Client::run()
+{
+    // each client keeps its recorded timing relative to the common start,
+    // so operations of different clients overlap as they did when recorded
+    for(size_t i=0; i<events.size(); ++i) {
+        WorkloadRecorder::Event const & event = events[i];
+        if(speed>0.0) {
+            double delay = event.time/speed - (epicsMonotonicGet() - startTime)*1e-9;
+            if(delay>0.0) epicsThreadSleep(delay);
+        }
+        execute(event);
+    }
+}
+
+Channel::shared_pointer Client::getChannel(string const & channelName)
+{
+    std::map<string,Channel::shared_pointer>::iterator iter = channels.find(channelName);
+    if(iter!=channels.end()) return iter->second;
+    Channel::shared_pointer channel = provider->createChannel(channelName,channelRequester,0);
+    if(channel) channels[channelName] = channel;
+    return channel;
+}
+
+void Client::execute(WorkloadRecorder::Event const & event)
+{
+    Channel::shared_pointer channel = getChannel(event.channelName);
+    if(!channel) {
+        ++failures;
+        return;
+    }
+    string key = event.channelName + '\t' + event.request;
+    PVStructurePtr pvRequest;
+    if(event.operation!=WorkloadRecorder::createChannel) {
+        pvRequest = CreateRequest::create()->createRequest(event.request);
+        if(!pvRequest) {
+            ++failures;
+            return;
+        }
+    }
+    // objects are created before the timer starts, as a client would do once
+    ChannelGet::shared_pointer channelGet;
+    ChannelProcess::shared_pointer channelProcess;
+    PVStructurePtr pvPut;
+    BitSetPtr putBitSet;
+    Put put;
+    switch(event.operation) {
+    case WorkloadRecorder::get:
+        channelGet = gets[key];
+        if(!channelGet) channelGet = gets[key] = channel->createChannelGet(getRequester,pvRequest);
+        if(!channelGet) { ++failures; return; }
+        break;
+    case WorkloadRecorder::process:
+        channelProcess = processes[key];
+        if(!channelProcess) {
+            channelProcess = processes[key] =
+                channel->createChannelProcess(processRequester,pvRequest);
+        }
+        if(!channelProcess) { ++failures; return; }
+        break;
+    case WorkloadRecorder::put:
+        put = puts[key];
+        if(!put.channelPut) {
+            put.requester = ReplayPutRequester::shared_pointer(new ReplayPutRequester());
+            put.channelPut = channel->createChannelPut(put.requester,pvRequest);
+            puts[key] = put;
+        }
+        if(!put.channelPut || !put.requester->structure) { ++failures; return; }
+        pvPut = getPVDataCreate()->createPVStructure(put.requester->structure);
+        putBitSet = BitSetPtr(new BitSet(pvPut->getNumberFields()));
+        try {
+            std::istringstream in(event.value);
+            parseJSON(in,*pvPut,putBitSet.get());
+        } catch(std::exception &) {
+            ++failures;
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+    uint64 start = epicsMonotonicGet();
+    switch(event.operation) {
+    case WorkloadRecorder::createChannel:
+        extraChannels.push_back(
+            provider->createChannel(event.channelName,channelRequester,0));
+        break;
+    case WorkloadRecorder::get:
+        channelGet->get();
+        break;
+    case WorkloadRecorder::put:
+        put.channelPut->put(pvPut,putBitSet);
+        break;
+    case WorkloadRecorder::process:
+        channelProcess->process();
+        break;
+    case WorkloadRecorder::monitor:
+    {
+        MonitorPtr monitor = channel->createMonitor(monitorRequester,pvRequest);
+        if(!monitor) { ++failures; return; }
+        monitor->start();
+        monitors.push_back(monitor);
+        break;
+    }
+    default:
+        return;
+    }
+    latencies[event.operation].push_back((epicsMonotonicGet() - start)*1e-9);
+}
+
+static double percentile(vector<double> const & sorted,double fraction)
+{
+    size_t index = static_cast<size_t>(fraction*(sorted.size()-1) + 0.5);
+    return sorted[index];
+}
+
+static void report(vector<Client *> const & clients,double elapsed)
+{
+    Latencies latencies(WorkloadRecorder::numberOperations);
+    size_t failures = 0;
+    size_t monitorEvents = 0;
+    for(size_t i=0; i<clients.size(); ++i) {
+        Client * client = clients[i];
+        for(size_t j=0; j<latencies.size(); ++j) {
+            latencies[j].insert(latencies[j].end(),
+                client->latencies[j].begin(),client->latencies[j].end());
+        }
+        failures += client->failures;
+        monitorEvents += client->getMonitorEvents();
+    }
+    size_t total = 0;
+    std::cout << "operation        count      ops/s    p50(us)    p90(us)    p99(us)    max(us)\n";
+    for(size_t i=0; i<latencies.size(); ++i) {
+        vector<double> & values = latencies[i];
+        if(values.empty()) continue;
+        total += values.size();
+        std::sort(values.begin(),values.end());
+        std::cout.width(14);
+        std::cout << std::left
+                  << WorkloadRecorder::getOperationName(static_cast<WorkloadRecorder::Operation>(i))
+                  << std::right;
+        std::cout.width(8);
+        std::cout << values.size();
+        std::cout.width(11);
+        std::cout << static_cast<size_t>(values.size()/elapsed);
+        double fractions[] = {0.5,0.9,0.99,1.0};
+        for(size_t j=0; j<4; ++j) {
+            std::cout.width(11);
+            std::cout << static_cast<size_t>(percentile(values,fractions[j])*1e6 + 0.5);
+        }
+        std::cout << "\n";
+    }
+    std::cout << "total " << total << " operations by " << clients.size() << " clients in "
+              << elapsed << " seconds, "
+              << (elapsed>0.0 ? total/elapsed : 0.0) << " ops/s\n";
+    std::cout << "monitor events " << monitorEvents
+              << " failures " << failures << "\n";
+}
+
+int main(int argc,char *argv[])
+{
+    string fileName;
+    double speed = 1.0;
+    int opt;
+    while((opt = getopt(argc, argv, "f:s:h")) != -1) {
+        switch(opt) {
+            case 'f':
+               fileName = optarg;
+               break;
+            case 's':
+               speed = atof(optarg);
+               break;
+            case 'h':
+               std::cout << " -f captureFile -s speed -h \n";
+               std::cout << "speed 0 replays as fast as possible\n";
+               std::cout << "default\n";
+               std::cout << "-s " << speed << "\n";
+               return 0;
+            default:
+                std::cerr<<"Unknown argument: "<<opt<<"\n";
+                return -1;
+        }
+    }
+    std::ifstream in(fileName.c_str());
+    if(fileName.empty() || !in) {
+        std::cerr << "can not open capture file \"" << fileName << "\"\n";
+        return -1;
+    }
+    // records are created first, then each recorded client replays in its own thread
+    std::map<size_t,Client *> clientMap;
+    vector<Client *> clients;
+    size_t failures = 0;
+    WorkloadRecorder::Event event;
+    size_t lineNumber = 0;
+    try {
+        while(WorkloadRecorder::read(in,event,lineNumber)) {
+            if(event.operation==WorkloadRecorder::record) {
+                if(!createRecord(event)) ++failures;
+                continue;
+            }
+            Client * & client = clientMap[event.client];
+            if(!client) {
+                client = new Client(event.client);
+                clients.push_back(client);
+            }
+            client->add(event);
+        }
+    } catch(std::exception & ex) {
+        std::cerr << fileName << " " << ex.what() << "\n";
+        return -1;
+    }
+    uint64 start = epicsMonotonicGet();
+    for(size_t i=0; i<clients.size(); ++i) clients[i]->start(speed,start);
+    for(size_t i=0; i<clients.size(); ++i) clients[i]->wait();
+    double elapsed = (epicsMonotonicGet() - start)*1e-9;
+    if(failures>0) std::cout << "records not created " << failures << "\n";
+    report(clients,elapsed);
+    for(size_t i=0; i<clients.size(); ++i) delete clients[i];
+    return 0;
+}
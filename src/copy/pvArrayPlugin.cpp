@@ -24,6 +24,19 @@ namespace epics { namespace pvCopy{
 static ConvertPtr convert = getConvert();
 static std::string name("array");
 
+template<typename T>
+static void shareSlice(
+    PVScalarArray & copyArray,
+    PVScalarArray const & masterArray,
+    size_t offset,
+    size_t count)
+{
+    shared_vector<const T> data;
+    masterArray.getAs<T>(data);
+    data.slice(offset,count);
+    copyArray.putFrom<T>(data);
+}
+
 PVArrayPlugin::PVArrayPlugin()
 {
 }
@@ -185,6 +198,10 @@ bool PVArrayFilter::filter(const PVFieldPtr & pvField,const BitSetPtr & bitSet,b
         }
         long indfrom = start;
         long indto = 0;
+        if(increment==1 && shareSubArray(*copyArray,*masterArray,indfrom,len)) {
+            bitSet->set(pvField->getFieldOffset());
+            return true;
+        }
         copyArray->setCapacity(len);
         if(increment==1) {
             copy(*masterArray,indfrom,1,*copyArray,indto,1,len);
@@ -222,4 +239,29 @@ string PVArrayFilter::getName()
     return name;
 }
 
+bool PVArrayFilter::shareSubArray(
+    PVScalarArray & copyArray,
+    PVScalarArray const & masterArray,
+    size_t offset,
+    size_t count)
+{
+    ScalarType scalarType = masterArray.getScalarArray()->getElementType();
+    if(copyArray.getScalarArray()->getElementType()!=scalarType) return false;
+    switch(scalarType) {
+    case pvBoolean: shareSlice<boolean>(copyArray,masterArray,offset,count); break;
+    case pvByte: shareSlice<int8>(copyArray,masterArray,offset,count); break;
+    case pvShort: shareSlice<int16>(copyArray,masterArray,offset,count); break;
+    case pvInt: shareSlice<int32>(copyArray,masterArray,offset,count); break;
+    case pvLong: shareSlice<int64>(copyArray,masterArray,offset,count); break;
+    case pvUByte: shareSlice<uint8>(copyArray,masterArray,offset,count); break;
+    case pvUShort: shareSlice<uint16>(copyArray,masterArray,offset,count); break;
+    case pvUInt: shareSlice<uint32>(copyArray,masterArray,offset,count); break;
+    case pvULong: shareSlice<uint64>(copyArray,masterArray,offset,count); break;
+    case pvFloat: shareSlice<float>(copyArray,masterArray,offset,count); break;
+    case pvDouble: shareSlice<double>(copyArray,masterArray,offset,count); break;
+    case pvString: shareSlice<string>(copyArray,masterArray,offset,count); break;
+    }
+    return true;
+}
+
 }}
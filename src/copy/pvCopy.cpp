@@ -10,6 +10,7 @@
 #include <stdexcept>
 #include <memory>
 #include <sstream>
+#include <algorithm>
 
 #include <epicsThread.h>
 #include <pv/pvData.h>
@@ -63,6 +64,43 @@ struct CopyNode {
 
 static CopyNodePtr NULLCopyNode;
 
+/*
+ * Arrays are copied by sharing the master's buffer.
+ * If the copy already shares it, the copy is up to date and
+ * neither a copy nor an element by element compare is needed.
+ */
+static bool sharesBuffer(PVFieldPtr const & pvCopy,PVFieldPtr const & pvMaster)
+{
+    Type type = pvCopy->getField()->getType();
+    if(type!=pvMaster->getField()->getType()) return false;
+    if(type==scalarArray) {
+        PVScalarArray const & copy = static_cast<PVScalarArray const &>(*pvCopy);
+        PVScalarArray const & master = static_cast<PVScalarArray const &>(*pvMaster);
+        if(copy.getScalarArray()->getElementType()
+        != master.getScalarArray()->getElementType()) return false;
+        shared_vector<const void> copyData;
+        shared_vector<const void> masterData;
+        copy.getAs<void>(copyData);
+        master.getAs<void>(masterData);
+        return copyData.data()==masterData.data() && copyData.size()==masterData.size();
+    }
+    if(type==structureArray) {
+        PVStructureArray::const_svector copyData =
+            static_cast<PVStructureArray const &>(*pvCopy).view();
+        PVStructureArray::const_svector masterData =
+            static_cast<PVStructureArray const &>(*pvMaster).view();
+        return copyData.data()==masterData.data() && copyData.size()==masterData.size();
+    }
+    if(type==unionArray) {
+        PVUnionArray::const_svector copyData =
+            static_cast<PVUnionArray const &>(*pvCopy).view();
+        PVUnionArray::const_svector masterData =
+            static_cast<PVUnionArray const &>(*pvMaster).view();
+        return copyData.data()==masterData.data() && copyData.size()==masterData.size();
+    }
+    return false;
+}
+
 typedef std::vector<CopyNodePtr> CopyNodePtrArray;
 typedef std::tr1::shared_ptr<CopyNodePtrArray> CopyNodePtrArrayPtr;
 
@@ -88,6 +126,7 @@ PVCopyPtr PVCopy::create(
     bool result = pvCopy->init(pvStructure);
     if(!result) return PVCopyPtr();
     pvCopy->traverseMasterInitPlugin();
+    pvCopy->initMasterOffsets();
 //cout << pvCopy->dump() << endl;
     return pvCopy;
 }
@@ -354,6 +393,7 @@ void PVCopy::updateCopySetBitSet(
     BitSetPtr const & bitSet)
 {
     if(pvCopy->getField()->getType()!=epics::pvData::structure) {
+        if(sharesBuffer(pvCopy,pvMaster)) return;
         if(*pvCopy==*pvMaster) return;
         pvCopy->copy(*pvMaster);
         bitSet->set(pvCopy->getFieldOffset());
@@ -407,6 +447,7 @@ void PVCopy::updateCopyFromBitSet(
     if(!node->isStructure) {
         if(result) return;
         PVFieldPtr pvMaster = node->masterPVField;
+        if(sharesBuffer(pvCopy,pvMaster)) return;
         pvCopy->copy(*pvMaster);
         return;
     }
@@ -424,7 +465,8 @@ void PVCopy::updateCopyFromBitSet(
 
 PVCopy::PVCopy(
     PVStructurePtr const &pvMaster)
-: pvMaster(pvMaster)
+: pvMaster(pvMaster),
+  filtered(false)
 {
 }
 
@@ -635,6 +677,7 @@ void PVCopy::initPlugin(
         if(pvFilters[numfilter]) ++numfilter;
     }
     if(numfilter==0) return;
+    filtered = true;
     node->pvFilters.resize(numfilter);
     for(size_t i=0; i<numfilter; ++i) node->pvFilters[i] = pvFilters[i];
 }
@@ -657,6 +700,73 @@ void PVCopy::traverseMasterInitPlugin(CopyNodePtr const & node)
     }
 }
 
+void PVCopy::initMasterOffsets()
+{
+    size_t base = pvMaster->getFieldOffset();
+    MasterOffset none;
+    none.copyOffset = string::npos;
+    none.nextOffset = 0;
+    masterOffsets.assign(pvMaster->getNumberFields(),none);
+    vector<PVFieldPtr> stack;
+    stack.push_back(pvMaster);
+    while(!stack.empty()) {
+        PVFieldPtr pvField = stack.back();
+        stack.pop_back();
+        masterOffsets[pvField->getFieldOffset()-base].nextOffset =
+            pvField->getNextFieldOffset() - base;
+        if(pvField->getField()->getType()!=structure) continue;
+        PVFieldPtrArray const & pvFields =
+            static_pointer_cast<PVStructure>(pvField)->getPVFields();
+        stack.insert(stack.end(),pvFields.begin(),pvFields.end());
+    }
+    initMasterOffsets(headNode);
+    std::sort(copyNodeOffsets.begin(),copyNodeOffsets.end());
+}
+
+void PVCopy::initMasterOffsets(CopyNodePtr const & node)
+{
+    if(node->isStructure) {
+        CopyStructureNodePtr structureNode = static_pointer_cast<CopyStructureNode>(node);
+        CopyNodePtrArrayPtr nodes = structureNode->nodes;
+        for(size_t i=0; i<nodes->size(); ++i) {
+            initMasterOffsets((*nodes)[i]);
+        }
+        return;
+    }
+    // a copy node copies the whole master subtree
+    size_t masterOffset = node->masterPVField->getFieldOffset() - pvMaster->getFieldOffset();
+    size_t num = node->masterPVField->getNumberFields();
+    for(size_t i=0; i<num; ++i) {
+        masterOffsets[masterOffset+i].copyOffset = node->structureOffset + i;
+    }
+    copyNodeOffsets.push_back(std::make_pair(masterOffset,node->structureOffset));
+}
+
+void PVCopy::mapMasterBitSet(
+    BitSet const &masterBitSet,
+    BitSet &copyBitSet)
+{
+    size_t base = pvMaster->getFieldOffset();
+    int32 bit = masterBitSet.nextSetBit(base);
+    while(bit>=0) {
+        size_t offset = bit - base;
+        if(offset>=masterOffsets.size()) break;
+        MasterOffset const & entry = masterOffsets[offset];
+        if(entry.copyOffset!=string::npos) {
+            copyBitSet.set(entry.copyOffset);
+        } else {
+            // an ancestor of copied fields or a field that is not copied
+            vector<std::pair<size_t,size_t> >::const_iterator iter = std::lower_bound(
+                copyNodeOffsets.begin(),copyNodeOffsets.end(),
+                std::make_pair(offset,size_t(0)));
+            for(; iter!=copyNodeOffsets.end() && iter->first<entry.nextOffset; ++iter) {
+                copyBitSet.set(iter->second);
+            }
+        }
+        bit = masterBitSet.nextSetBit(bit+1);
+    }
+}
+
 CopyNodePtr PVCopy::getCopyOffset(
         CopyStructureNodePtr const &structureNode,
         PVFieldPtr const &masterPVField)
@@ -13,6 +13,7 @@
 #define epicsExportSharedSymbols
 #include "pv/pvPlugin.h"
 #include "pv/pvTimestampPlugin.h"
+#include "pv/timeStampService.h"
 
 
 using std::string;
@@ -84,34 +85,66 @@ PVTimestampFilter::PVTimestampFilter(bool current,bool copy,PVFieldPtr const & m
   copy(copy),
   master(master)
 {
+    pvMasterTimeStamp.attach(master);
+    StructureConstPtr structure =
+        static_pointer_cast<const Structure>(master->getField());
+    secondsIndex = structure->getFieldIndex("secondsPastEpoch");
+    nanosecondsIndex = structure->getFieldIndex("nanoseconds");
+    userTagIndex = structure->getFieldIndex("userTag");
 }
 
+bool PVTimestampFilter::getCopy(const PVFieldPtr & pvCopy)
+{
+    if(pvCopy->getField()!=master->getField()) {
+        if(!pvTimeStamp.attach(pvCopy)) return false;
+        pvTimeStamp.get(timeStamp);
+        return true;
+    }
+    // the copy has the same introspection interface as the master
+    const PVFieldPtrArray & pvFields =
+        static_cast<PVStructure *>(pvCopy.get())->getPVFields();
+    timeStamp.put(
+        static_cast<PVLong *>(pvFields[secondsIndex].get())->get(),
+        static_cast<PVInt *>(pvFields[nanosecondsIndex].get())->get());
+    timeStamp.setUserTag(static_cast<PVInt *>(pvFields[userTagIndex].get())->get());
+    return true;
+}
+
+bool PVTimestampFilter::putCopy(const PVFieldPtr & pvCopy)
+{
+    if(pvCopy->getField()!=master->getField()) {
+        if(!pvTimeStamp.attach(pvCopy)) return false;
+        pvTimeStamp.set(timeStamp);
+        return true;
+    }
+    const PVFieldPtrArray & pvFields =
+        static_cast<PVStructure *>(pvCopy.get())->getPVFields();
+    static_cast<PVLong *>(pvFields[secondsIndex].get())->put(timeStamp.getSecondsPastEpoch());
+    static_cast<PVInt *>(pvFields[nanosecondsIndex].get())->put(timeStamp.getNanoseconds());
+    static_cast<PVInt *>(pvFields[userTagIndex].get())->put(timeStamp.getUserTag());
+    return true;
+}
 
 bool PVTimestampFilter::filter(const PVFieldPtr & pvCopy,const BitSetPtr & bitSet,bool toCopy)
 {
     if(current) {
-        timeStamp.getCurrent();
+        epics::pvDatabase::TimeStampService::getCurrent(timeStamp);
         if(toCopy) {
-            if(!pvTimeStamp.attach(pvCopy)) return false;
+            if(!putCopy(pvCopy)) return false;
         } else {
-            if(!pvTimeStamp.attach(master)) return false;
+            pvMasterTimeStamp.set(timeStamp);
         }
-        pvTimeStamp.set(timeStamp);
         bitSet->set(pvCopy->getFieldOffset());
         return true;
      }
      if(copy) {
         if(toCopy) {
-            if(!pvTimeStamp.attach(master)) return false;
-            pvTimeStamp.get(timeStamp);
-            if(!pvTimeStamp.attach(pvCopy)) return false;
-            pvTimeStamp.set(timeStamp);
+            pvMasterTimeStamp.get(timeStamp);
+            if(!putCopy(pvCopy)) return false;
             bitSet->set(pvCopy->getFieldOffset());
         } else {
-            if(!pvTimeStamp.attach(pvCopy)) return false;
-            pvTimeStamp.get(timeStamp);
-            if(!pvTimeStamp.attach(master)) return false;
-            pvTimeStamp.set(timeStamp);
+            if(!getCopy(pvCopy)) return false;
+            pvMasterTimeStamp.set(timeStamp);
         }
         return true;
      }
@@ -0,0 +1,271 @@
+/* lockProfiler.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <epicsGuard.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsAtomic.h>
+
+#define epicsExportSharedSymbols
+#include "pv/lockProfiler.h"
+
+using namespace epics::pvData;
+using std::string;
+using std::vector;
+
+namespace epics { namespace pvDatabase {
+
+namespace {
+
+typedef std::pair<string,int> Key;
+typedef std::map<Key,LockProfiler::Entry> EntryMap;
+
+epicsThreadOnceId profilerOnce = EPICS_THREAD_ONCE_INIT;
+epicsThreadPrivateId siteId;
+// the acquisitions of the thread until the next sample, 0 if it has not sampled yet
+epicsThreadPrivateId countdownId;
+epics::pvData::Mutex *entryMutex;
+EntryMap *entryMap;
+int enabled = 0;
+int sampleInterval = 16;
+
+const char * siteNames[LockProfiler::numberSites] = {
+    "other",
+    "get",
+    "put",
+    "putGet",
+    "array",
+    "process",
+    "monitorStart",
+    "scan"
+};
+
+// a plain read, so that a disabled profiler costs one load.
+// A stale value only delays when a Scope starts to record its site.
+inline bool enabledRelaxed()
+{
+    return *static_cast<volatile int *>(&enabled)!=0;
+}
+
+void createProfiler(void *)
+{
+    siteId = epicsThreadPrivateCreate();
+    countdownId = epicsThreadPrivateCreate();
+    entryMutex = new epics::pvData::Mutex();
+    entryMap = new EntryMap();
+}
+
+void initProfiler()
+{
+    epicsThreadOnce(&profilerOnce,createProfiler,0);
+}
+
+struct CompareWait {
+    bool operator()(LockProfiler::Entry const & a,LockProfiler::Entry const & b) const
+    { return a.totalWait>b.totalWait;}
+};
+
+struct CompareHold {
+    bool operator()(LockProfiler::Entry const & a,LockProfiler::Entry const & b) const
+    { return a.totalHold>b.totalHold;}
+};
+
+}
+
+void LockProfiler::enable(unsigned int interval)
+{
+    initProfiler();
+    epicsAtomicSetIntT(&sampleInterval,(interval==0) ? 1 : interval);
+    epicsAtomicSetIntT(&enabled,1);
+}
+
+void LockProfiler::disable()
+{
+    epicsAtomicSetIntT(&enabled,0);
+}
+
+bool LockProfiler::isEnabled()
+{
+    return epicsAtomicGetIntT(&enabled)!=0;
+}
+
+void LockProfiler::clear()
+{
+    initProfiler();
+    epicsGuard<epics::pvData::Mutex> guard(*entryMutex);
+    entryMap->clear();
+}
+
+const char * LockProfiler::getSiteName(Site site)
+{
+    if(site<0 || site>=numberSites) return "unknown";
+    return siteNames[site];
+}
+
+LockProfiler::Site LockProfiler::getSite()
+{
+    initProfiler();
+    void *value = epicsThreadPrivateGet(siteId);
+    if(!value) return other;
+    return static_cast<Site>(reinterpret_cast<size_t>(value));
+}
+
+bool LockProfiler::sample()
+{
+    if(epicsAtomicGetIntT(&enabled)==0) return false;
+    // counted per thread, so that no lock acquisition writes shared memory
+    size_t count = reinterpret_cast<size_t>(epicsThreadPrivateGet(countdownId));
+    if(count==0) count = epicsAtomicGetIntT(&sampleInterval);
+    if(count<=1) {
+        size_t interval = epicsAtomicGetIntT(&sampleInterval);
+        epicsThreadPrivateSet(countdownId,reinterpret_cast<void *>(interval));
+        return true;
+    }
+    epicsThreadPrivateSet(countdownId,reinterpret_cast<void *>(count - 1));
+    return false;
+}
+
+void LockProfiler::addSample(
+    string const & lockName,
+    Site site,
+    uint64 wait,
+    uint64 hold)
+{
+    initProfiler();
+    double waitSeconds = wait*1e-9;
+    double holdSeconds = hold*1e-9;
+    epicsGuard<epics::pvData::Mutex> guard(*entryMutex);
+    Key key(lockName,site);
+    EntryMap::iterator iter = entryMap->find(key);
+    if(iter==entryMap->end()) {
+        Entry entry;
+        entry.lockName = lockName;
+        entry.site = site;
+        entry.samples = 0;
+        entry.totalWait = entry.maxWait = 0.0;
+        entry.totalHold = entry.maxHold = 0.0;
+        iter = entryMap->insert(EntryMap::value_type(key,entry)).first;
+    }
+    Entry & entry = iter->second;
+    ++entry.samples;
+    entry.totalWait += waitSeconds;
+    entry.totalHold += holdSeconds;
+    if(waitSeconds>entry.maxWait) entry.maxWait = waitSeconds;
+    if(holdSeconds>entry.maxHold) entry.maxHold = holdSeconds;
+}
+
+vector<LockProfiler::Entry> LockProfiler::getTop(size_t number,bool byHold)
+{
+    initProfiler();
+    vector<Entry> entries;
+    {
+        epicsGuard<epics::pvData::Mutex> guard(*entryMutex);
+        entries.reserve(entryMap->size());
+        for(EntryMap::iterator iter = entryMap->begin(); iter!=entryMap->end(); ++iter) {
+            entries.push_back(iter->second);
+        }
+    }
+    if(number>entries.size()) number = entries.size();
+    if(byHold) {
+        std::partial_sort(entries.begin(),entries.begin()+number,entries.end(),CompareHold());
+    } else {
+        std::partial_sort(entries.begin(),entries.begin()+number,entries.end(),CompareWait());
+    }
+    entries.resize(number);
+    return entries;
+}
+
+void LockProfiler::report(std::ostream & out,size_t number)
+{
+    for(int i=0; i<2; ++i) {
+        bool byHold = (i==1);
+        vector<Entry> entries = getTop(number,byHold);
+        out << "top " << entries.size() << " by " << (byHold ? "hold" : "wait") << " time\n";
+        out << "     samples   totalWait(us)     maxWait(us)   totalHold(us)     maxHold(us)  site lockName\n";
+        for(size_t j=0; j<entries.size(); ++j) {
+            Entry const & entry = entries[j];
+            out << std::setw(12) << entry.samples
+                << std::setw(16) << std::fixed << std::setprecision(1) << entry.totalWait*1e6
+                << std::setw(16) << entry.maxWait*1e6
+                << std::setw(16) << entry.totalHold*1e6
+                << std::setw(16) << entry.maxHold*1e6
+                << "  " << getSiteName(entry.site)
+                << " " << entry.lockName << "\n";
+        }
+    }
+}
+
+bool LockProfiler::dumpFolded(string const & fileName)
+{
+    initProfiler();
+    std::ofstream out(fileName.c_str());
+    if(!out) return false;
+    epicsGuard<epics::pvData::Mutex> guard(*entryMutex);
+    for(EntryMap::iterator iter = entryMap->begin(); iter!=entryMap->end(); ++iter) {
+        Entry const & entry = iter->second;
+        const char * siteName = getSiteName(entry.site);
+        out << "wait;" << siteName << ";" << entry.lockName << " "
+            << static_cast<uint64>(entry.totalWait*1e6) << "\n";
+        out << "hold;" << siteName << ";" << entry.lockName << " "
+            << static_cast<uint64>(entry.totalHold*1e6) << "\n";
+    }
+    return out.good();
+}
+
+LockProfiler::Scope::Scope(Site site)
+: previous(other),
+  active(enabledRelaxed())
+{
+    if(!active) return;
+    previous = getSite();
+    epicsThreadPrivateSet(siteId,reinterpret_cast<void *>(static_cast<size_t>(site)));
+}
+
+LockProfiler::Scope::~Scope()
+{
+    if(!active) return;
+    epicsThreadPrivateSet(siteId,reinterpret_cast<void *>(static_cast<size_t>(previous)));
+}
+
+LockProfiler::MutexGuard::MutexGuard(epics::pvData::Mutex & mutex,const char * lockName)
+: mutex(mutex),
+  lockName(lockName),
+  start(0),
+  wait(0),
+  site(other)
+{
+    if(!sample()) {
+        mutex.lock();
+        return;
+    }
+    uint64 begin = epicsMonotonicGet();
+    mutex.lock();
+    start = epicsMonotonicGet();
+    wait = start - begin;
+    site = getSite();
+}
+
+LockProfiler::MutexGuard::~MutexGuard()
+{
+    if(start==0) {
+        mutex.unlock();
+        return;
+    }
+    uint64 hold = epicsMonotonicGet() - start;
+    mutex.unlock();
+    addSample(lockName,site,wait,hold);
+}
+
+}}
@@ -10,8 +10,13 @@
  */
 
 #include <epicsGuard.h>
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+#include <algorithm>
 #include <list>
 #include <map>
+#include <set>
+#include <pv/event.h>
 #include <pv/pvData.h>
 #include <pv/pvTimeStamp.h>
 #include <pv/rpcService.h>
@@ -23,6 +28,7 @@
 #include "pv/pvArrayPlugin.h"
 #include "pv/pvTimestampPlugin.h"
 #include "pv/pvDeadbandPlugin.h"
+#include "pv/lockProfiler.h"
 
 using std::tr1::static_pointer_cast;
 using namespace epics::pvData;
@@ -35,6 +41,142 @@ namespace epics { namespace pvDatabase {
 
 static PVDatabasePtr pvDatabaseMaster;
 
+/**
+ * Detaches the listeners and clients of removed records.
+ * A single low priority thread does the work so that removeRecord
+ * does not wait for the callbacks into pvAccess requesters.
+ */
+class PVRecordReaper :
+    public epicsThreadRunable
+{
+public:
+    PVRecordReaper()
+    : thread(*this,"pvDatabaseReaper",
+        epicsThreadGetStackSize(epicsThreadStackSmall),
+        epicsThreadPriorityLow),
+      stopping(false)
+    {
+        thread.start();
+    }
+    virtual ~PVRecordReaper()
+    {
+        {
+            epicsGuard<epics::pvData::Mutex> guard(mutex);
+            stopping = true;
+        }
+        wakeup.signal();
+        thread.exitWait();
+    }
+    void add(PVRecordPtr const & record)
+    {
+        {
+            epicsGuard<epics::pvData::Mutex> guard(mutex);
+            removedList.push_back(record);
+        }
+        wakeup.signal();
+    }
+    virtual void run()
+    {
+        while(true) {
+            std::list<PVRecordPtr> work;
+            {
+                epicsGuard<epics::pvData::Mutex> guard(mutex);
+                work.swap(removedList);
+                if(work.empty() && stopping) return;
+            }
+            if(work.empty()) {
+                wakeup.wait();
+                continue;
+            }
+            std::list<PVRecordPtr>::iterator iter;
+            for(iter = work.begin(); iter!=work.end(); ++iter) {
+                PVRecordPtr pvRecord = *iter;
+                try {
+                    pvRecord->unlistenClients();
+                } catch (std::exception& ex) {
+                    cout << "PVRecordReaper record " << pvRecord->getRecordName()
+                         << " exception " << ex.what() << endl;
+                }
+            }
+        }
+    }
+private:
+    epicsThread thread;
+    epics::pvData::Event wakeup;
+    epics::pvData::Mutex mutex;
+    std::list<PVRecordPtr> removedList;
+    bool stopping;
+};
+
+/**
+ * A counting Bloom filter of the record names.
+ * Each counter has 8 bits and four are packed in an int.
+ * A counter that reaches 255 saturates and is never decremented,
+ * which can only cause false positives.
+ * mayContain does not take a lock. add and remove are called while
+ * the database lock is held, so there is only one writer.
+ */
+class RecordNameFilter
+{
+public:
+    explicit RecordNameFilter(size_t size)
+    : counters(size/4,0),
+      mask(size-1)
+    {}
+    size_t getSize() const { return counters.size()*4;}
+    void add(string const & name) { update(name,true);}
+    void remove(string const & name) { update(name,false);}
+    bool mayContain(string const & name) const
+    {
+        uint64 h1,h2;
+        hash(name,h1,h2);
+        for(size_t i=0; i<numberHashes; ++i) {
+            size_t index = (h1 + i*h2)&mask;
+            unsigned int word = epicsAtomicGetIntT(&counters[index>>2]);
+            if(((word>>((index&3)*8))&0xff)==0) return false;
+        }
+        return true;
+    }
+private:
+    static const size_t numberHashes = 3;
+    // FNV-1a, split into the two hashes of double hashing
+    static void hash(string const & name,uint64 & h1,uint64 & h2)
+    {
+        uint64 value = 14695981039346656037ULL;
+        for(size_t i=0; i<name.size(); ++i) {
+            value ^= static_cast<unsigned char>(name[i]);
+            value *= 1099511628211ULL;
+        }
+        h1 = value;
+        h2 = (value>>32) | 1;
+    }
+    void update(string const & name,bool add)
+    {
+        uint64 h1,h2;
+        hash(name,h1,h2);
+        for(size_t i=0; i<numberHashes; ++i) {
+            size_t index = (h1 + i*h2)&mask;
+            int * counter = &counters[index>>2];
+            unsigned int word = epicsAtomicGetIntT(counter);
+            unsigned int shift = (index&3)*8;
+            unsigned int count = (word>>shift)&0xff;
+            if(count==0xff) continue;
+            count = add ? count + 1 : count - 1;
+            word = (word & ~(0xffu<<shift)) | (count<<shift);
+            epicsAtomicSetIntT(counter,static_cast<int>(word));
+        }
+    }
+    std::vector<int> counters;
+    size_t mask;
+};
+
+// the filter is replaced while findRecord reads it without the lock
+static RecordNameFilter * getNameFilter(RecordNameFilter ** nameFilter)
+{
+    return static_cast<RecordNameFilter *>(
+        epicsAtomicGetPtrT(reinterpret_cast<EpicsAtomicPtrT *>(nameFilter)));
+}
+
 PVDatabasePtr PVDatabase::getMaster()
 {
     static bool firstTime = true;
@@ -49,13 +191,23 @@ PVDatabasePtr PVDatabase::getMaster()
 }
 
 PVDatabase::PVDatabase()
+: nameFilter(0),
+  numberNames(0),
+  findHits(0),
+  findMisses(0),
+  findFiltered(0),
+  generation(0),
+  deferredClientDetach(false)
 {
     if(DEBUG_LEVEL>0) cout << "PVDatabase::PVDatabase()\n";
+    nameFilters.push_back(std::tr1::shared_ptr<RecordNameFilter>(new RecordNameFilter(1024)));
+    nameFilter = nameFilters.back().get();
 }
 
 PVDatabase::~PVDatabase()
 {
     if(DEBUG_LEVEL>0) cout << "PVDatabase::~PVDatabase()\n";
+    reaper.reset();
 }
 
 void PVDatabase::lock() {
@@ -68,20 +220,107 @@ void PVDatabase::unlock() {
 
 PVRecordPtr PVDatabase::findRecord(string const& recordName)
 {
-    epicsGuard<epics::pvData::Mutex> guard(mutex);
+    if(!getNameFilter(&nameFilter)->mayContain(recordName)) {
+        epicsAtomicIncrSizeT(&findMisses);
+        epicsAtomicIncrSizeT(&findFiltered);
+        return PVRecordPtr();
+    }
+    LockProfiler::MutexGuard guard(mutex,"PVDatabase");
     PVRecordMap::iterator iter = recordMap.find(recordName);
     if(iter!=recordMap.end()) {
+         epicsAtomicIncrSizeT(&findHits);
          return (*iter).second;
     }
+    epicsAtomicIncrSizeT(&findMisses);
     return PVRecordPtr();
 }
 
+namespace {
+
+struct NameOrder
+{
+    explicit NameOrder(vector<string> const & names) : names(names) {}
+    bool operator()(size_t a,size_t b) const { return names[a]<names[b];}
+    vector<string> const & names;
+};
+
+}
+
+size_t PVDatabase::findRecords(
+    vector<string> const & recordNames,
+    vector<PVRecordPtr> & records)
+{
+    size_t number = recordNames.size();
+    records.assign(number,PVRecordPtr());
+    vector<size_t> order;
+    order.reserve(number);
+    RecordNameFilter * filter = getNameFilter(&nameFilter);
+    for(size_t i=0; i<number; ++i) {
+        if(filter->mayContain(recordNames[i])) order.push_back(i);
+    }
+    size_t filtered = number - order.size();
+    std::sort(order.begin(),order.end(),NameOrder(recordNames));
+    size_t hits = 0;
+    {
+        LockProfiler::MutexGuard guard(mutex,"PVDatabase");
+        string const * last = 0;
+        PVRecordPtr lastRecord;
+        for(size_t i=0; i<order.size(); ++i) {
+            string const & name = recordNames[order[i]];
+            if(!last || *last!=name) {
+                last = &name;
+                PVRecordMap::iterator iter = recordMap.find(name);
+                lastRecord = (iter==recordMap.end()) ? PVRecordPtr() : iter->second;
+            }
+            if(!lastRecord) continue;
+            records[order[i]] = lastRecord;
+            ++hits;
+        }
+    }
+    epicsAtomicAddSizeT(&findHits,hits);
+    epicsAtomicAddSizeT(&findMisses,number - hits);
+    epicsAtomicAddSizeT(&findFiltered,filtered);
+    return hits;
+}
+
+void PVDatabase::addName(string const & name)
+{
+    // caller holds the lock
+    RecordNameFilter * filter = nameFilter;
+    ++numberNames;
+    epicsAtomicIncrSizeT(&generation);
+    if(numberNames*8 > filter->getSize()) {
+        // a new filter with at least 16 counters per name, published when complete
+        size_t size = filter->getSize();
+        while(numberNames*16 > size) size *= 2;
+        std::tr1::shared_ptr<RecordNameFilter> newFilter(new RecordNameFilter(size));
+        PVRecordMap::iterator iter;
+        for(iter = recordMap.begin(); iter!=recordMap.end(); ++iter) {
+            if(iter->first!=name) newFilter->add(iter->first);
+        }
+        newFilter->add(name);
+        // the replaced filter is kept, a lookup may still be using it
+        nameFilters.push_back(newFilter);
+        epicsAtomicSetPtrT(reinterpret_cast<EpicsAtomicPtrT *>(&nameFilter),newFilter.get());
+        return;
+    }
+    filter->add(name);
+}
+
+void PVDatabase::removeName(string const & name)
+{
+    // caller holds the lock
+    nameFilter->remove(name);
+    --numberNames;
+    epicsAtomicIncrSizeT(&generation);
+}
+
 bool PVDatabase::addRecord(PVRecordPtr const & record)
 {
     if(record->getTraceLevel()>0) {
         cout << "PVDatabase::addRecord " << record->getRecordName() << endl;
     }
-    epicsGuard<epics::pvData::Mutex> guard(mutex);
+    LockProfiler::MutexGuard guard(mutex,"PVDatabase");
     string recordName = record->getRecordName();
     PVRecordMap::iterator iter = recordMap.find(recordName);
     if(iter!=recordMap.end()) {
@@ -89,47 +328,111 @@ bool PVDatabase::addRecord(PVRecordPtr const & record)
     }
     record->start();
     recordMap.insert(PVRecordMap::value_type(recordName,record));
+    addName(recordName);
     return true;
 }
 
 PVRecordWPtr PVDatabase::removeFromMap(PVRecordPtr const & record)
 {
-    epicsGuard<epics::pvData::Mutex> guard(mutex);
+    LockProfiler::MutexGuard guard(mutex,"PVDatabase");
     string recordName = record->getRecordName();
     PVRecordMap::iterator iter = recordMap.find(recordName);
     if(iter!=recordMap.end())  {
         PVRecordPtr pvRecord = (*iter).second;
         recordMap.erase(iter);
+        removeName(recordName);
+        std::pair<AliasMultiMap::iterator,AliasMultiMap::iterator> aliases =
+            recordAliases.equal_range(recordName);
+        for(AliasMultiMap::iterator alias = aliases.first; alias!=aliases.second; ++alias) {
+            recordMap.erase(alias->second);
+            aliasMap.erase(alias->second);
+            removeName(alias->second);
+        }
+        recordAliases.erase(aliases.first,aliases.second);
         return pvRecord->shared_from_this();
     }
     return PVRecordWPtr();
 }
 
+void PVDatabase::detachClients(PVRecordPtr const & record)
+{
+    // Called without the database lock so that lookups are not blocked
+    // while listeners and clients are notified.
+    {
+        epicsGuard<epics::pvData::Mutex> guard(record->mutex);
+        record->removed = true;
+    }
+    record->clearPVCopyCache();
+    PVRecordReaperPtr reaper;
+    {
+        epicsGuard<epics::pvData::Mutex> guard(mutex);
+        if(deferredClientDetach) {
+            if(!this->reaper) this->reaper = PVRecordReaperPtr(new PVRecordReaper());
+            reaper = this->reaper;
+        }
+    }
+    if(reaper) {
+        reaper->add(record);
+        return;
+    }
+    record->unlistenClients();
+}
+
 bool PVDatabase::removeRecord(PVRecordPtr const & record)
 {
     if(record->getTraceLevel()>0) {
         cout << "PVDatabase::removeRecord " << record->getRecordName() << endl;
     }
-    epicsGuard<epics::pvData::Mutex> guard(mutex);
     PVRecordWPtr pvRecord = removeFromMap(record);
-    if(pvRecord.use_count()!=0) {
-        pvRecord.lock()->unlistenClients();
-        return true;
-    }
-    return false;
+    if(pvRecord.expired()) return false;
+    detachClients(record);
+    return true;
+}
+
+void PVDatabase::setDeferredClientDetach(bool value)
+{
+    epicsGuard<epics::pvData::Mutex> guard(mutex);
+    deferredClientDetach = value;
 }
 
-PVStringArrayPtr PVDatabase::getRecordNames()
+bool PVDatabase::getDeferredClientDetach()
 {
     epicsGuard<epics::pvData::Mutex> guard(mutex);
-    PVStringArrayPtr xxx;
+    return deferredClientDetach;
+}
+
+void PVDatabase::getFindStatistics(size_t & hits,size_t & misses,size_t & filtered)
+{
+    hits = epicsAtomicGetSizeT(&findHits);
+    misses = epicsAtomicGetSizeT(&findMisses);
+    filtered = epicsAtomicGetSizeT(&findFiltered);
+}
+
+void PVDatabase::clearFindStatistics()
+{
+    epicsAtomicSetSizeT(&findHits,0);
+    epicsAtomicSetSizeT(&findMisses,0);
+    epicsAtomicSetSizeT(&findFiltered,0);
+}
+
+size_t PVDatabase::getGeneration()
+{
+    return epicsAtomicGetSizeT(&generation);
+}
+
+PVStringArrayPtr PVDatabase::getRecordNames(bool includeAliases)
+{
+    LockProfiler::MutexGuard guard(mutex,"PVDatabase");
     PVStringArrayPtr pvStringArray = static_pointer_cast<PVStringArray>
         (getPVDataCreate()->createPVScalarArray(pvString));
     size_t len = recordMap.size();
+    if(!includeAliases) len -= aliasMap.size();
     shared_vector<string> names(len);
     PVRecordMap::iterator iter;
     size_t i = 0;
     for(iter = recordMap.begin(); iter!=recordMap.end(); ++iter) {
+        if(!includeAliases && !aliasMap.empty()
+        && aliasMap.find(iter->first)!=aliasMap.end()) continue;
         names[i++] = (*iter).first;
     }
     shared_vector<const string> temp(freeze(names));
@@ -137,4 +440,59 @@ PVStringArrayPtr PVDatabase::getRecordNames()
     return pvStringArray;
 }
 
+bool PVDatabase::addAlias(string const & aliasName,string const & recordName)
+{
+    return addAliases(vector<string>(1,aliasName),vector<string>(1,recordName));
+}
+
+bool PVDatabase::addAliases(
+    vector<string> const & aliasNames,
+    vector<string> const & recordNames)
+{
+    size_t number = aliasNames.size();
+    if(recordNames.size()!=number) return false;
+    LockProfiler::MutexGuard guard(mutex,"PVDatabase");
+    // check every alias before any is added
+    vector<PVRecordPtr> records(number);
+    std::set<string> added;
+    for(size_t i=0; i<number; ++i) {
+        if(recordMap.find(aliasNames[i])!=recordMap.end()) return false;
+        if(!added.insert(aliasNames[i]).second) return false;
+        PVRecordMap::iterator iter = recordMap.find(recordNames[i]);
+        if(iter==recordMap.end()) return false;
+        records[i] = iter->second;
+    }
+    for(size_t i=0; i<number; ++i) {
+        recordMap.insert(PVRecordMap::value_type(aliasNames[i],records[i]));
+        aliasMap.insert(std::make_pair(aliasNames[i],records[i]->getRecordName()));
+        recordAliases.insert(std::make_pair(records[i]->getRecordName(),aliasNames[i]));
+        addName(aliasNames[i]);
+    }
+    return true;
+}
+
+bool PVDatabase::removeAliases(vector<string> const & aliasNames)
+{
+    LockProfiler::MutexGuard guard(mutex,"PVDatabase");
+    std::set<string> removed;
+    for(size_t i=0; i<aliasNames.size(); ++i) {
+        if(aliasMap.find(aliasNames[i])==aliasMap.end()) return false;
+        if(!removed.insert(aliasNames[i]).second) return false;
+    }
+    for(size_t i=0; i<aliasNames.size(); ++i) {
+        std::map<string,string>::iterator alias = aliasMap.find(aliasNames[i]);
+        std::pair<AliasMultiMap::iterator,AliasMultiMap::iterator> aliases =
+            recordAliases.equal_range(alias->second);
+        for(AliasMultiMap::iterator iter = aliases.first; iter!=aliases.second; ++iter) {
+            if(iter->second!=aliasNames[i]) continue;
+            recordAliases.erase(iter);
+            break;
+        }
+        aliasMap.erase(alias);
+        recordMap.erase(aliasNames[i]);
+        removeName(aliasNames[i]);
+    }
+    return true;
+}
+
 }}
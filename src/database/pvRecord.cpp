@@ -9,6 +9,8 @@
  * @date 2012.11.21
  */
 #include <list>
+#include <sstream>
+#include <stdexcept>
 #include <epicsGuard.h>
 #include <epicsThread.h>
 #include <pv/status.h>
@@ -23,10 +25,14 @@
 #include <pv/pvData.h>
 #include <pv/rpcService.h>
 #include <pv/pvTimeStamp.h>
+#include <epicsTime.h>
 
 #define epicsExportSharedSymbols
 #include "pv/pvStructureCopy.h"
 #include "pv/pvDatabase.h"
+#include "pv/timeStampService.h"
+#include "pv/lockProfiler.h"
+#include "pv/traceLog.h"
 
 using std::tr1::static_pointer_cast;
 using namespace epics::pvData;
@@ -52,17 +58,41 @@ PVRecord::PVRecord(
     PVStructurePtr const & pvStructure)
 : recordName(recordName),
   pvStructure(pvStructure),
+  clientReapThreshold(16),
+  pvCopyCacheSize(8),
+  coalesceProcess(false),
+  processRunning(false),
+  processStarted(0),
   depthGroupPut(0),
   traceLevel(0),
+  traceId(0),
+  groupPutStart(0),
+  lockDepth(0),
+  lockStart(0),
+  lockWait(0),
+  lockSite(LockProfiler::other),
+  removed(false),
+  pooled(false),
   isAddListener(false)
 {
 }
 
+const size_t PVRecord::noClientHandle;
+
 PVRecord::~PVRecord()
 {
     if(traceLevel>0) {
         cout << "~PVRecord() " << recordName << endl;
     }
+    pvRecordFieldIndex.clear();
+    // members that still refer to the data would make release keep it out of the pool
+    pvCopyCache.clear();
+    pvListenerList.clear();
+    pvSecondsPastEpoch.reset();
+    pvNanoseconds.reset();
+    if(pooled && pvRecordStructure) {
+        PVRecordPool::getPool()->release(pvStructure,pvRecordStructure);
+    }
 }
 
 void PVRecord::unlistenClients()
@@ -80,11 +110,10 @@ void PVRecord::unlistenClients()
         listener->unlisten(shared_from_this());
     }
     pvListenerList.clear();
-    for (std::list<PVRecordClientWPtr>::iterator iter = clientList.begin();
-         iter!=clientList.end();
-         iter++ )
+    // a client may remove itself while being detached, so index the slots.
+    for(size_t i=0; i<clientList.size(); ++i)
     {
-        PVRecordClientPtr client = iter->lock();
+        PVRecordClientPtr client = clientList[i].client.lock();
         if(!client) continue;
         if(traceLevel>0) {
             cout << "PVRecord::remove() calling client->detach " << recordName << endl;
@@ -92,6 +121,7 @@ void PVRecord::unlistenClients()
         client->detach(shared_from_this());
     }
     clientList.clear();
+    clientFreeList.clear();
 }
 
 
@@ -100,21 +130,56 @@ void PVRecord::remove()
     if(traceLevel>0) {
             cout << "PVRecord::remove() " << recordName << endl;
     }
-    unlistenClients();
-    epicsGuard<epics::pvData::Mutex> guard(mutex);
     PVDatabasePtr pvDatabase(PVDatabase::getMaster());
     if(pvDatabase) pvDatabase->removeFromMap(shared_from_this());
-    pvTimeStamp.detach();
+    {
+        epicsGuard<epics::pvData::Mutex> guard(mutex);
+        pvSecondsPastEpoch.reset();
+        pvNanoseconds.reset();
+    }
+    if(pvDatabase) {
+        pvDatabase->detachClients(shared_from_this());
+    } else {
+        {
+            epicsGuard<epics::pvData::Mutex> guard(mutex);
+            removed = true;
+        }
+        clearPVCopyCache();
+        unlistenClients();
+    }
+}
+
+void PVRecord::clearPVCopyCache()
+{
+    // the cached PVCopys refer to pvStructure, which keeps it out of the pool
+    epicsGuard<epics::pvData::Mutex> guard(pvCopyCacheMutex);
+    pvCopyCache.clear();
+    pvCopyCacheSize = 0;
 }
 
 void PVRecord::initPVRecord()
 {
-    PVRecordStructurePtr parent;
-    pvRecordStructure = PVRecordStructurePtr(
-        new PVRecordStructure(pvStructure,parent,shared_from_this()));
-    pvRecordStructure->init();
+    PVRecordStructurePtr recycled;
+    pooled = PVRecordPool::getPool()->takePVRecordStructure(pvStructure,recycled);
+    if(recycled) {
+        pvRecordStructure = recycled;
+        pvRecordStructure->rebind(shared_from_this());
+    } else {
+        PVRecordStructurePtr parent;
+        pvRecordStructure = PVRecordStructurePtr(
+            new PVRecordStructure(pvStructure,parent,shared_from_this()));
+        pvRecordStructure->init();
+    }
+    pvRecordFieldIndex.clear();
+    pvRecordFieldIndex.resize(pvStructure->getNumberFields());
+    indexPVRecordField(pvRecordStructure);
     PVFieldPtr pvField = pvStructure->getSubField("timeStamp");
-    if(pvField) pvTimeStamp.attach(pvField);
+    PVTimeStamp pvTimeStamp;
+    if(pvField && pvTimeStamp.attach(pvField)) {
+        PVStructurePtr pvTS = static_pointer_cast<PVStructure>(pvField);
+        pvSecondsPastEpoch = pvTS->getSubField<PVLong>("secondsPastEpoch");
+        pvNanoseconds = pvTS->getSubField<PVInt>("nanoseconds");
+    }
 }
 
 void PVRecord::process()
@@ -122,40 +187,29 @@ void PVRecord::process()
     if(traceLevel>2) {
         cout << "PVRecord::process() " << recordName << endl;
     }
-    if(pvTimeStamp.isAttached()) {
-        pvTimeStamp.get(timeStamp);
-        timeStamp.getCurrent();
-        pvTimeStamp.set(timeStamp);
+    if(pvSecondsPastEpoch) {
+        TimeStampService::getCurrent(timeStamp);
+        pvSecondsPastEpoch->put(timeStamp.getSecondsPastEpoch());
+        pvNanoseconds->put(timeStamp.getNanoseconds());
     }
 }
 
 
-PVRecordFieldPtr PVRecord::findPVRecordField(PVFieldPtr const & pvField)
+void PVRecord::indexPVRecordField(PVRecordFieldPtr const & pvRecordField)
 {
-    return findPVRecordField(pvRecordStructure,pvField);
-}
-
-PVRecordFieldPtr PVRecord::findPVRecordField(
-    PVRecordStructurePtr const & pvrs,
-        PVFieldPtr const & pvField)
-{
-    size_t desiredOffset = pvField->getFieldOffset();
-    PVFieldPtr pvf = pvrs->getPVField();
-    size_t offset = pvf->getFieldOffset();
-    if(offset==desiredOffset) return pvrs;
-    PVRecordFieldPtrArrayPtr  pvrfpap = pvrs->getPVRecordFields();
-    PVRecordFieldPtrArray::iterator iter;
-    for (iter = pvrfpap.get()->begin(); iter!=pvrfpap.get()->end(); iter++ ) {
-        PVRecordFieldPtr pvrf = *iter;
-        pvf = pvrf->getPVField();
-        offset = pvf->getFieldOffset();
-        if(offset==desiredOffset) return pvrf;
-        size_t nextOffset = pvf->getNextFieldOffset();
-        if(nextOffset<=desiredOffset) continue;
-        return findPVRecordField(
-            static_pointer_cast<PVRecordStructure>(pvrf),
-            pvField);
+    pvRecordFieldIndex[pvRecordField->getPVField()->getFieldOffset()] = pvRecordField;
+    if(!pvRecordField->isStructure) return;
+    PVRecordFieldPtrArrayPtr pvRecordFields =
+        static_pointer_cast<PVRecordStructure>(pvRecordField)->getPVRecordFields();
+    for(size_t i=0; i<pvRecordFields->size(); ++i) {
+        indexPVRecordField((*pvRecordFields)[i]);
     }
+}
+
+PVRecordFieldPtr PVRecord::findPVRecordField(PVFieldPtr const & pvField)
+{
+    size_t offset = pvField->getFieldOffset();
+    if(offset<pvRecordFieldIndex.size()) return pvRecordFieldIndex[offset];
     throw std::logic_error(
         recordName + " pvField "
         + pvField->getFieldName() + " not in PVRecord");
@@ -165,21 +219,43 @@ void PVRecord::lock() {
     if(traceLevel>2) {
         cout << "PVRecord::lock() " << recordName << endl;
     }
+    if(!LockProfiler::sample()) {
+        mutex.lock();
+        ++lockDepth;
+        return;
+    }
+    epics::pvData::uint64 begin = epicsMonotonicGet();
     mutex.lock();
+    if(++lockDepth>1) return;
+    // only the outermost lock is timed, a recursive lock does not wait.
+    lockStart = epicsMonotonicGet();
+    lockWait = lockStart - begin;
+    lockSite = LockProfiler::getSite();
 }
 
 void PVRecord::unlock() {
     if(traceLevel>2) {
         cout << "PVRecord::unlock() " << recordName << endl;
     }
+    if(--lockDepth>0 || lockStart==0) {
+        mutex.unlock();
+        return;
+    }
+    epics::pvData::uint64 hold = epicsMonotonicGet() - lockStart;
+    epics::pvData::uint64 wait = lockWait;
+    LockProfiler::Site site = static_cast<LockProfiler::Site>(lockSite);
+    lockStart = 0;
     mutex.unlock();
+    LockProfiler::addSample(recordName,site,wait,hold);
 }
 
 bool PVRecord::tryLock() {
     if(traceLevel>2) {
         cout << "PVRecord::tryLock() " << recordName << endl;
     }
-    return mutex.tryLock();
+    if(!mutex.tryLock()) return false;
+    ++lockDepth;
+    return true;
 }
 
 void PVRecord::lockOtherRecord(PVRecordPtr const & otherRecord)
@@ -197,36 +273,83 @@ void PVRecord::lockOtherRecord(PVRecordPtr const & otherRecord)
 }
 
 bool PVRecord::addPVRecordClient(PVRecordClientPtr const & pvRecordClient)
+{
+    size_t handle;
+    return addPVRecordClient(pvRecordClient,handle);
+}
+
+bool PVRecord::addPVRecordClient(
+    PVRecordClientPtr const & pvRecordClient,
+    size_t & handle)
 {
     if(traceLevel>1) {
         cout << "PVRecord::addPVRecordClient() " << recordName << endl;
     }
     epicsGuard<epics::pvData::Mutex> guard(mutex);
-    // clean clientList
-    bool clientListClean = false;
-    while(!clientListClean) {
-        if(clientList.empty()) break;
-        clientListClean = true;
-        std::list<PVRecordClientWPtr>::iterator iter;
-        for (iter = clientList.begin();
-             iter!=clientList.end();
-             iter++ )
-        {
-            PVRecordClientPtr client = iter->lock();
-            if(client) continue;
-            if(traceLevel>1) {
-                 cout << "PVRecord::addPVRecordClient() erasing client"
-                      << recordName << endl;
-            }
-            clientList.erase(iter);
-            clientListClean = false;
-            break;
-        }
+    if(removed) return false;
+    if(clientFreeList.empty() && clientList.size()>=clientReapThreshold) {
+        reapClients();
+    }
+    ClientSlot slot;
+    slot.client = pvRecordClient;
+    slot.id = pvRecordClient.get();
+    if(clientFreeList.empty()) {
+        handle = clientList.size();
+        clientList.push_back(slot);
+    } else {
+        handle = clientFreeList.back();
+        clientFreeList.pop_back();
+        clientList[handle] = slot;
     }
-    clientList.push_back(pvRecordClient);
     return true;
 }
 
+void PVRecord::removePVRecordClient(
+    size_t handle,
+    PVRecordClient const * pvRecordClient)
+{
+    if(traceLevel>1) {
+        cout << "PVRecord::removePVRecordClient() " << recordName << endl;
+    }
+    epicsGuard<epics::pvData::Mutex> guard(mutex);
+    if(handle>=clientList.size()) return;
+    ClientSlot & slot = clientList[handle];
+    if(slot.id!=pvRecordClient) return;
+    slot.client.reset();
+    slot.id = NULL;
+    clientFreeList.push_back(handle);
+}
+
+size_t PVRecord::getNumberClients()
+{
+    epicsGuard<epics::pvData::Mutex> guard(mutex);
+    return clientList.size() - clientFreeList.size();
+}
+
+void PVRecord::reapClients()
+{
+    // caller holds the lock.
+    // Called only when no slot is free so expired clients are released
+    // in one pass, and the threshold keeps the cost amortized O(1) per add.
+    size_t numberLive = 0;
+    for(size_t i=0; i<clientList.size(); ++i) {
+        ClientSlot & slot = clientList[i];
+        if(slot.id && !slot.client.expired()) {
+            ++numberLive;
+            continue;
+        }
+        if(!slot.id) continue;
+        if(traceLevel>1) {
+             cout << "PVRecord::reapClients() erasing client "
+                  << recordName << endl;
+        }
+        slot.client.reset();
+        slot.id = NULL;
+        clientFreeList.push_back(i);
+    }
+    clientReapThreshold = (numberLive<8) ? 16 : 2*numberLive;
+}
+
 bool PVRecord::addListener(
     PVListenerPtr const & pvListener,
     epics::pvCopy::PVCopyPtr const & pvCopy)
@@ -235,6 +358,7 @@ bool PVRecord::addListener(
         cout << "PVRecord::addListener() " << recordName << endl;
     }
     epicsGuard<epics::pvData::Mutex> guard(mutex);
+    if(removed) return false;
     pvListenerList.push_back(pvListener);
     this->pvListener = pvListener;
     isAddListener = true;
@@ -255,6 +379,153 @@ void PVRecord::nextMasterPVField(PVFieldPtr const & pvField)
      }
 }
 
+void PVRecord::processGroupPut()
+{
+    ProcessWaiter waiter;
+    waiter.run = false;
+    bool coalesce = false;
+    bool wait = false;
+    {
+        epicsGuard<epics::pvData::Mutex> guard(processMutex);
+        // a caller that arrives while a process runs always waits,
+        // even if coalescing was just disabled
+        if(coalesceProcess || processRunning) {
+            coalesce = true;
+            // the first process that starts after this call
+            waiter.number = processStarted + 1;
+            if(processRunning) {
+                processWaiters.push_back(&waiter);
+                wait = true;
+            } else {
+                processRunning = true;
+            }
+        }
+    }
+    if(!coalesce) {
+        epicsGuard<PVRecord> guard(*this);
+        beginGroupPut();
+        process();
+        endGroupPut();
+        return;
+    }
+    if(wait) {
+        waiter.event.wait();
+        string error;
+        bool run;
+        {
+            // the processing caller signals while it holds processMutex
+            epicsGuard<epics::pvData::Mutex> guard(processMutex);
+            error = waiter.error;
+            run = waiter.run;
+        }
+        if(!run) {
+            if(!error.empty()) throw std::runtime_error(error);
+            return;
+        }
+        // processRunning was handed to this caller
+    }
+    // This caller does its own process and at most one follow-up for the callers
+    // that arrived meanwhile. Then processRunning goes to a caller still waiting,
+    // so that no caller keeps processing for others under steady load.
+    string error;
+    for(int i=0; i<2; ++i) {
+        epics::pvData::uint64 number;
+        {
+            epicsGuard<epics::pvData::Mutex> guard(processMutex);
+            if(i>0 && processWaiters.empty()) break;
+            number = ++processStarted;
+        }
+        string message;
+        {
+            epicsGuard<PVRecord> guard(*this);
+            beginGroupPut();
+            try {
+                process();
+            } catch(std::exception & ex) {
+                message = ex.what();
+            }
+            endGroupPut();
+        }
+        if(i==0) error = message;
+        epicsGuard<epics::pvData::Mutex> guard(processMutex);
+        size_t keep = 0;
+        for(size_t j=0; j<processWaiters.size(); ++j) {
+            ProcessWaiter * next = processWaiters[j];
+            if(next->number<=number) {
+                next->error = message;
+                next->event.signal();
+            } else {
+                processWaiters[keep++] = next;
+            }
+        }
+        processWaiters.resize(keep);
+    }
+    {
+        epicsGuard<epics::pvData::Mutex> guard(processMutex);
+        if(processWaiters.empty()) {
+            processRunning = false;
+        } else {
+            // the longest waiting caller runs the process it waits for
+            ProcessWaiter * next = processWaiters.front();
+            processWaiters.erase(processWaiters.begin());
+            next->run = true;
+            next->event.signal();
+        }
+    }
+    if(!error.empty()) throw std::runtime_error(error);
+}
+
+void PVRecord::setCoalesceProcess(bool value)
+{
+    epicsGuard<epics::pvData::Mutex> guard(processMutex);
+    coalesceProcess = value;
+}
+
+bool PVRecord::getCoalesceProcess()
+{
+    epicsGuard<epics::pvData::Mutex> guard(processMutex);
+    return coalesceProcess;
+}
+
+epics::pvCopy::PVCopyPtr PVRecord::getPVCopy(
+    PVStructurePtr const & pvRequest,
+    string const & structureName)
+{
+    std::ostringstream os;
+    os << structureName << '\n' << *pvRequest;
+    string key(os.str());
+    typedef std::list<std::pair<string,epics::pvCopy::PVCopyPtr> >::iterator Iter;
+    {
+        epicsGuard<epics::pvData::Mutex> guard(pvCopyCacheMutex);
+        for(Iter iter = pvCopyCache.begin(); iter!=pvCopyCache.end(); ++iter) {
+            if(iter->first!=key) continue;
+            pvCopyCache.splice(pvCopyCache.begin(),pvCopyCache,iter);
+            return iter->second;
+        }
+    }
+    epics::pvCopy::PVCopyPtr pvCopy =
+        epics::pvCopy::PVCopy::create(pvStructure,pvRequest,structureName);
+    // filters keep state for each client
+    if(!pvCopy || pvCopy->hasFilters()) return pvCopy;
+    // take the structure built by PVCopy::init so that two clients never get it
+    pvCopy->createPVStructure();
+    epicsGuard<epics::pvData::Mutex> guard(pvCopyCacheMutex);
+    if(pvCopyCacheSize==0) return pvCopy;
+    for(Iter iter = pvCopyCache.begin(); iter!=pvCopyCache.end(); ++iter) {
+        if(iter->first==key) return iter->second;
+    }
+    pvCopyCache.push_front(std::make_pair(key,pvCopy));
+    if(pvCopyCache.size()>pvCopyCacheSize) pvCopyCache.pop_back();
+    return pvCopy;
+}
+
+void PVRecord::setPVCopyCacheSize(size_t size)
+{
+    epicsGuard<epics::pvData::Mutex> guard(pvCopyCacheMutex);
+    pvCopyCacheSize = size;
+    while(pvCopyCache.size()>pvCopyCacheSize) pvCopyCache.pop_back();
+}
+
 bool PVRecord::removeListener(
     PVListenerPtr const & pvListener,
     epics::pvCopy::PVCopyPtr const & pvCopy)
@@ -280,12 +551,36 @@ bool PVRecord::removeListener(
     return false;
 }
 
+void PVRecord::postBitSet(size_t fieldOffset)
+{
+    // caller holds the lock.
+    changedBitSet.set(fieldOffset);
+    if(depthGroupPut>0) return;
+    callBitSetListeners();
+}
+
+void PVRecord::callBitSetListeners()
+{
+    std::list<PVListenerWPtr>::iterator iter;
+    for (iter = pvListenerList.begin(); iter!=pvListenerList.end(); iter++)
+    {
+        PVListenerPtr listener = iter->lock();
+        if(!listener.get()) continue;
+        if(!listener->isBitSetListener()) continue;
+        listener->dataPut(shared_from_this(),changedBitSet);
+    }
+    changedBitSet.clear();
+}
+
 void PVRecord::beginGroupPut()
 {
    if(++depthGroupPut>1) return;
     if(traceLevel>2) {
         cout << "PVRecord::beginGroupPut() " << recordName << endl;
     }
+   // the process and every monitor filter in this group put share one time
+   TimeStampService::beginBatch();
+   if(traceId) groupPutStart = TraceLog::now();
    std::list<PVListenerWPtr>::iterator iter;
    for (iter = pvListenerList.begin(); iter!=pvListenerList.end(); iter++)
    {
@@ -301,6 +596,7 @@ void PVRecord::endGroupPut()
     if(traceLevel>2) {
         cout << "PVRecord::endGroupPut() " << recordName << endl;
     }
+   if(changedBitSet.nextSetBit(0)>=0) callBitSetListeners();
    std::list<PVListenerWPtr>::iterator iter;
    for (iter = pvListenerList.begin(); iter!=pvListenerList.end(); iter++)
    {
@@ -308,6 +604,9 @@ void PVRecord::endGroupPut()
        if(!listener.get()) continue;
        listener->endGroupPut(shared_from_this());
    }
+   TimeStampService::endBatch();
+   if(traceId && groupPutStart) TraceLog::add(traceId,TraceLog::groupPut,groupPutStart);
+   groupPutStart = 0;
 }
 
 std::ostream& operator<<(std::ostream& o, const PVRecord& record)
@@ -324,7 +623,11 @@ PVRecordField::PVRecordField(
     PVFieldPtr const & pvField,
     PVRecordStructurePtr const &parent,
     PVRecordPtr const & pvRecord)
-:  pvField(pvField),
+:  ancestorListeners(0),
+   subtreeListeners(0),
+   bitSetListeners(0),
+   fieldOffset(pvField->getFieldOffset()),
+   pvField(pvField),
    isStructure(pvField->getField()->getType()==structure ? true : false),
    parent(parent),
    pvRecord(pvRecord)
@@ -333,25 +636,26 @@ PVRecordField::PVRecordField(
 
 void PVRecordField::init()
 {
-    fullFieldName = pvField.lock()->getFieldName();
-    PVRecordStructurePtr pvParent(parent.lock());
-    while(pvParent) {
-        string parentName = pvParent->getPVField()->getFieldName();
-        if(parentName.size()>0) {
-            fullFieldName = pvParent->getPVField()->getFieldName()
-                + '.' + fullFieldName;
-        }
-        pvParent = pvParent->getParent();
-    }
-    PVRecordPtr pvRecord(this->pvRecord.lock());
-    if(fullFieldName.size()>0) {
-        fullName = pvRecord->getRecordName() + '.' + fullFieldName;
-    } else {
-        fullName = pvRecord->getRecordName();
-    }
+    // the names are built on demand, most fields are never asked for them.
     pvField.lock()->setPostHandler(shared_from_this());
 }
 
+void PVRecordField::rebind(PVRecordPtr const & pvRecord)
+{
+    // the post handler stays attached, only the record changes.
+    this->pvRecord = pvRecord;
+    pvListenerList.clear();
+    ancestorListeners = 0;
+    subtreeListeners = 0;
+    bitSetListeners = 0;
+    if(!isStructure) return;
+    PVRecordFieldPtrArrayPtr pvRecordFields =
+        static_cast<PVRecordStructure *>(this)->getPVRecordFields();
+    for(size_t i=0; i<pvRecordFields->size(); ++i) {
+        (*pvRecordFields)[i]->rebind(pvRecord);
+    }
+}
+
 PVRecordStructurePtr PVRecordField::getParent()
 {
     return parent.lock();
@@ -359,9 +663,23 @@ PVRecordStructurePtr PVRecordField::getParent()
 
 PVFieldPtr PVRecordField::getPVField() {return pvField.lock();}
 
-string PVRecordField::getFullFieldName() {return fullFieldName; }
+string PVRecordField::getFullFieldName()
+{
+    PVRecordStructurePtr pvParent(parent.lock());
+    if(!pvParent) return string();
+    string fullFieldName = pvParent->getFullFieldName();
+    if(fullFieldName.size()>0) fullFieldName += '.';
+    return fullFieldName + pvField.lock()->getFieldName();
+}
 
-string PVRecordField::getFullName() {return fullName; }
+string PVRecordField::getFullName()
+{
+    PVRecordPtr pvRecord(this->pvRecord.lock());
+    string fullName = pvRecord ? pvRecord->getRecordName() : string();
+    string fullFieldName = getFullFieldName();
+    if(fullFieldName.size()>0) fullName += '.' + fullFieldName;
+    return fullName;
+}
 
 PVRecordPtr PVRecordField::getPVRecord() {return pvRecord.lock();}
 
@@ -371,7 +689,13 @@ bool PVRecordField::addListener(PVListenerPtr const & pvListener)
     if(pvRecord && pvRecord->getTraceLevel()>1) {
          cout << "PVRecordField::addListener() " << getFullName() << endl;
     }
+    if(pvListener->isBitSetListener()) {
+        // the record keeps the changes, the field only needs to post them
+        updateListenerCounts(true,true);
+        return true;
+    }
     pvListenerList.push_back(pvListener);
+    updateListenerCounts(true,false);
     return true;
 }
 
@@ -381,24 +705,74 @@ void PVRecordField::removeListener(PVListenerPtr const & pvListener)
     if(pvRecord && pvRecord->getTraceLevel()>1) {
          cout << "PVRecordField::removeListener() " << getFullName() << endl;
     }
+    if(pvListener->isBitSetListener()) {
+        updateListenerCounts(false,true);
+        return;
+    }
     std::list<PVListenerWPtr>::iterator iter;
     for (iter = pvListenerList.begin(); iter!=pvListenerList.end(); iter++ ) {
         PVListenerPtr listener = iter->lock();
         if(!listener.get()) continue;
         if(listener.get()==pvListener.get()) {
             pvListenerList.erase(iter);
+            updateListenerCounts(false,false);
             return;
         }
     }
 }
 
+void PVRecordField::updateListenerCounts(bool add,bool bitSet)
+{
+    // caller holds the record lock.
+    PVRecordFieldPtr pvRecordField(shared_from_this());
+    while(pvRecordField) {
+        size_t & count = bitSet ?
+            pvRecordField->bitSetListeners : pvRecordField->subtreeListeners;
+        if(add) {
+            ++count;
+        } else {
+            --count;
+        }
+        pvRecordField = pvRecordField->parent.lock();
+    }
+    if(!isStructure) return;
+    PVRecordFieldPtrArrayPtr pvRecordFields =
+        static_cast<PVRecordStructure *>(this)->getPVRecordFields();
+    for(size_t i=0; i<pvRecordFields->size(); ++i) {
+        (*pvRecordFields)[i]->updateAncestorListeners(add,bitSet);
+    }
+}
+
+void PVRecordField::updateAncestorListeners(bool add,bool bitSet)
+{
+    size_t & count = bitSet ? bitSetListeners : ancestorListeners;
+    if(add) {
+        ++count;
+    } else {
+        --count;
+    }
+    if(!isStructure) return;
+    PVRecordFieldPtrArrayPtr pvRecordFields =
+        static_cast<PVRecordStructure *>(this)->getPVRecordFields();
+    for(size_t i=0; i<pvRecordFields->size(); ++i) {
+        (*pvRecordFields)[i]->updateAncestorListeners(add,bitSet);
+    }
+}
+
 void PVRecordField::postPut()
 {
-    PVRecordStructurePtr parent(this->parent.lock());;
-    if(parent) {
-        parent->postParent(shared_from_this());
+    if(bitSetListeners>0) {
+        PVRecordPtr pvRecord(this->pvRecord.lock());
+        if(pvRecord) pvRecord->postBitSet(fieldOffset);
+    }
+    // nothing more to do unless some field above or below has a listener.
+    if(ancestorListeners>0) {
+        PVRecordStructurePtr parent(this->parent.lock());
+        if(parent) {
+            parent->postParent(shared_from_this());
+        }
     }
-    postSubField();
+    if(subtreeListeners>0) postSubField();
 }
 
 void PVRecordField::postParent(PVRecordFieldPtr const & subField)
@@ -411,12 +785,14 @@ void PVRecordField::postParent(PVRecordFieldPtr const & subField)
         if(!listener.get()) continue;
         listener->dataPut(pvrs,subField);
     }
+    if(ancestorListeners==0) return;
     PVRecordStructurePtr parent(this->parent.lock());
     if(parent) parent->postParent(subField);
 }
 
 void PVRecordField::postSubField()
 {
+    if(subtreeListeners==0) return;
     callListener();
     if(isStructure) {
         PVRecordStructurePtr pvrs =
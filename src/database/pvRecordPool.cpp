@@ -0,0 +1,158 @@
+/* pvRecordPool.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+
+#include <epicsGuard.h>
+#include <epicsThread.h>
+#include <pv/pvData.h>
+
+#define epicsExportSharedSymbols
+#include "pv/pvDatabase.h"
+
+using namespace epics::pvData;
+using namespace std;
+
+namespace epics { namespace pvDatabase {
+
+static PVRecordPoolPtr pvRecordPool;
+static epicsThreadOnceId pvRecordPoolOnce = EPICS_THREAD_ONCE_INIT;
+
+void PVRecordPool::createPool(void *)
+{
+    pvRecordPool = PVRecordPoolPtr(new PVRecordPool());
+}
+
+PVRecordPoolPtr PVRecordPool::getPool()
+{
+    epicsThreadOnce(&pvRecordPoolOnce,&PVRecordPool::createPool,0);
+    return pvRecordPool;
+}
+
+PVRecordPool::PVRecordPool()
+: maxFree(100)
+{
+}
+
+PVRecordPool::~PVRecordPool()
+{
+}
+
+PVStructurePtr PVRecordPool::createPVStructure(StructureConstPtr const & structure)
+{
+    FreeEntry entry;
+    PVStructurePtr initial;
+    {
+        epicsGuard<epics::pvData::Mutex> guard(mutex);
+        StructureMap::iterator iter = structureMap.find(structure);
+        if(iter!=structureMap.end() && !iter->second.freeList.empty()) {
+            entry = iter->second.freeList.back();
+            iter->second.freeList.pop_back();
+            initial = iter->second.initial;
+        }
+    }
+    if(entry.pvStructure) {
+        // the listener lists were cleared on release so the posts go nowhere.
+        entry.pvStructure->copyUnchecked(*initial);
+    } else {
+        entry.pvStructure = getPVDataCreate()->createPVStructure(structure);
+    }
+    epicsGuard<epics::pvData::Mutex> guard(mutex);
+    if(allocatedMap.size()>=2*maxFree + 16) {
+        // PVStructures that never became a record are forgotten here
+        AllocatedMap::iterator iter = allocatedMap.begin();
+        while(iter!=allocatedMap.end()) {
+            if(iter->second.pvStructure.expired()) {
+                allocatedMap.erase(iter++);
+            } else {
+                ++iter;
+            }
+        }
+    }
+    Allocated allocated;
+    allocated.pvStructure = entry.pvStructure;
+    allocated.pvRecordStructure = entry.pvRecordStructure;
+    allocatedMap[entry.pvStructure.get()] = allocated;
+    return entry.pvStructure;
+}
+
+void PVRecordPool::setMaxFree(size_t maxFree)
+{
+    epicsGuard<epics::pvData::Mutex> guard(mutex);
+    this->maxFree = maxFree;
+    for(StructureMap::iterator iter = structureMap.begin();
+        iter!=structureMap.end(); ++iter)
+    {
+        if(iter->second.freeList.size()>maxFree) {
+            iter->second.freeList.resize(maxFree);
+        }
+    }
+}
+
+size_t PVRecordPool::getNumberFree(StructureConstPtr const & structure)
+{
+    epicsGuard<epics::pvData::Mutex> guard(mutex);
+    StructureMap::iterator iter = structureMap.find(structure);
+    if(iter==structureMap.end()) return 0;
+    return iter->second.freeList.size();
+}
+
+void PVRecordPool::clear()
+{
+    StructureMap temp;
+    {
+        epicsGuard<epics::pvData::Mutex> guard(mutex);
+        structureMap.swap(temp);
+    }
+}
+
+bool PVRecordPool::takePVRecordStructure(
+    PVStructurePtr const & pvStructure,
+    PVRecordStructurePtr & pvRecordStructure)
+{
+    epicsGuard<epics::pvData::Mutex> guard(mutex);
+    if(allocatedMap.empty()) return false;
+    AllocatedMap::iterator iter = allocatedMap.find(pvStructure.get());
+    if(iter==allocatedMap.end()) return false;
+    // the address may have been reused by a PVStructure that is not from the pool
+    bool result = (iter->second.pvStructure.lock()==pvStructure);
+    if(result) pvRecordStructure = iter->second.pvRecordStructure;
+    allocatedMap.erase(iter);
+    return result;
+}
+
+void PVRecordPool::release(
+    PVStructurePtr const & pvStructure,
+    PVRecordStructurePtr const & pvRecordStructure)
+{
+    // Something other than the record still uses the data.
+    // The top level PVStructure holds pvRecordStructure as its post handler,
+    // so that reference is expected.
+    if(pvStructure.use_count()>1 || pvRecordStructure.use_count()>2) return;
+    StructureConstPtr structure(pvStructure->getStructure());
+    PVStructurePtr initial;
+    {
+        epicsGuard<epics::pvData::Mutex> guard(mutex);
+        StructureEntry & structureEntry = structureMap[structure];
+        if(structureEntry.freeList.size()>=maxFree) return;
+        initial = structureEntry.initial;
+    }
+    if(!initial) initial = getPVDataCreate()->createPVStructure(structure);
+    pvRecordStructure->rebind(PVRecordPtr());
+    FreeEntry entry;
+    entry.pvStructure = pvStructure;
+    entry.pvRecordStructure = pvRecordStructure;
+    epicsGuard<epics::pvData::Mutex> guard(mutex);
+    StructureEntry & structureEntry = structureMap[structure];
+    if(!structureEntry.initial) structureEntry.initial = initial;
+    if(structureEntry.freeList.size()>=maxFree) return;
+    structureEntry.freeList.push_back(entry);
+}
+
+}}
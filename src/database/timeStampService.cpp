@@ -0,0 +1,112 @@
+/* timeStampService.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+
+#include <epicsThread.h>
+#include <epicsExit.h>
+#include <pv/timeStamp.h>
+
+#define epicsExportSharedSymbols
+#include "pv/timeStampService.h"
+
+using namespace epics::pvData;
+
+namespace epics { namespace pvDatabase {
+
+namespace {
+
+struct ThreadState {
+    ThreadState() : depth(0), valid(false) {}
+    int depth;
+    bool valid;
+    TimeStamp timeStamp;
+    TimeStamp lastIssued;
+};
+
+epicsThreadOnceId stateOnce = EPICS_THREAD_ONCE_INIT;
+epicsThreadPrivateId stateId;
+volatile int currentMode = TimeStampService::batch;
+
+void createState(void *)
+{
+    stateId = epicsThreadPrivateCreate();
+}
+
+void deleteState(void *arg)
+{
+    epicsThreadPrivateSet(stateId,0);
+    delete static_cast<ThreadState *>(arg);
+}
+
+ThreadState & getState()
+{
+    epicsThreadOnce(&stateOnce,createState,0);
+    ThreadState *state = static_cast<ThreadState *>(epicsThreadPrivateGet(stateId));
+    if(!state) {
+        state = new ThreadState();
+        epicsThreadPrivateSet(stateId,state);
+        // freed when the thread exits
+        epicsAtThreadExit(deleteState,state);
+    }
+    return *state;
+}
+
+void readClock(ThreadState & state,TimeStamp & timeStamp)
+{
+    timeStamp.getCurrent();
+    if(timeStamp<state.lastIssued) {
+        // the system clock was stepped back
+        timeStamp.put(state.lastIssued.getSecondsPastEpoch(),state.lastIssued.getNanoseconds());
+        return;
+    }
+    state.lastIssued.put(timeStamp.getSecondsPastEpoch(),timeStamp.getNanoseconds());
+}
+
+}
+
+void TimeStampService::getCurrent(TimeStamp & timeStamp)
+{
+    ThreadState & state = getState();
+    if(state.depth==0 || currentMode==perCall) {
+        readClock(state,timeStamp);
+        return;
+    }
+    if(!state.valid) {
+        readClock(state,state.timeStamp);
+        state.valid = true;
+    }
+    timeStamp.put(
+        state.timeStamp.getSecondsPastEpoch(),
+        state.timeStamp.getNanoseconds());
+}
+
+void TimeStampService::beginBatch()
+{
+    ++getState().depth;
+}
+
+void TimeStampService::endBatch()
+{
+    ThreadState & state = getState();
+    if(state.depth==0) return;
+    if(--state.depth==0) state.valid = false;
+}
+
+void TimeStampService::setMode(Mode mode)
+{
+    currentMode = mode;
+}
+
+TimeStampService::Mode TimeStampService::getMode()
+{
+    return static_cast<Mode>(currentMode);
+}
+
+}}
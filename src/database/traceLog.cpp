@@ -0,0 +1,352 @@
+/* traceLog.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+
+#include <map>
+#include <vector>
+#include <fstream>
+#include <epicsGuard.h>
+#include <epicsThread.h>
+#include <epicsExit.h>
+#include <epicsTime.h>
+#include <epicsAtomic.h>
+#include <pv/lock.h>
+#include <pv/event.h>
+
+#define epicsExportSharedSymbols
+#include "pv/pvDatabase.h"
+#include "pv/traceLog.h"
+
+using namespace epics::pvData;
+using std::string;
+using std::vector;
+
+namespace epics { namespace pvDatabase {
+
+namespace {
+
+struct TraceEvent {
+    uint64 start;
+    uint64 end;
+    uint32 traceId;
+    uint32 operation;
+};
+
+// written by one thread and read by the drainer.
+// When the thread exits the ring is retired and, once drained,
+// given to the next thread that needs a ring.
+struct Ring {
+    Ring(size_t size)
+    : events(size),
+      head(0),
+      tail(0),
+      tid(0),
+      named(false),
+      retired(0)
+    {}
+    vector<TraceEvent> events;
+    size_t head;
+    size_t tail;
+    size_t tid;
+    string threadName;
+    bool named;
+    int retired;
+};
+
+// the events of one ring copied out by the drainer
+struct Pending {
+    size_t tid;
+    string threadName;
+    bool writeName;
+    vector<TraceEvent> events;
+};
+
+const char * operationNames[TraceLog::numberOperations] = {
+    "groupPut",
+    "get",
+    "put",
+    "putGet",
+    "array",
+    "process",
+    "monitorEvent"
+};
+
+class Drainer;
+
+epicsThreadOnceId traceOnce = EPICS_THREAD_ONCE_INIT;
+epicsThreadPrivateId ringId;
+epics::pvData::Mutex *traceMutex;
+vector<Ring *> *rings;
+std::map<uint32,string> *recordNames;
+uint32 nextTraceId = 1;
+size_t nextTid = 1;
+size_t ringSize = 8192;
+size_t dropped = 0;
+int active = 0;
+std::ofstream *out;
+Drainer *drainer;
+
+void createTrace(void *)
+{
+    ringId = epicsThreadPrivateCreate();
+    traceMutex = new epics::pvData::Mutex();
+    rings = new vector<Ring *>();
+    recordNames = new std::map<uint32,string>();
+}
+
+void initTrace()
+{
+    epicsThreadOnce(&traceOnce,createTrace,0);
+}
+
+void writeString(string const & value)
+{
+    for(size_t i=0; i<value.size(); ++i) {
+        char c = value[i];
+        if(c=='"' || c=='\\') *out << '\\';
+        *out << c;
+    }
+}
+
+// caller holds traceMutex.
+// The new events are copied so that they are written without the lock.
+void collect(vector<Pending> & pending,std::map<uint32,string> & names)
+{
+    pending.resize(rings->size());
+    for(size_t i=0; i<rings->size(); ++i) {
+        Ring *ring = (*rings)[i];
+        Pending & copy = pending[i];
+        copy.tid = ring->tid;
+        copy.writeName = !ring->named;
+        if(copy.writeName) copy.threadName = ring->threadName;
+        ring->named = true;
+        copy.events.clear();
+        size_t head = epicsAtomicGetSizeT(&ring->head);
+        size_t tail = ring->tail;
+        size_t size = ring->events.size();
+        for(; tail!=head; ++tail) {
+            TraceEvent const & event = ring->events[tail % size];
+            copy.events.push_back(event);
+            if(names.find(event.traceId)==names.end()) {
+                names[event.traceId] = (*recordNames)[event.traceId];
+            }
+        }
+        epicsAtomicSetSizeT(&ring->tail,tail);
+    }
+}
+
+// only the drainer writes to out while it exists
+void write(vector<Pending> const & pending,std::map<uint32,string> & names)
+{
+    for(size_t i=0; i<pending.size(); ++i) {
+        Pending const & copy = pending[i];
+        if(copy.writeName) {
+            *out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << copy.tid
+                 << ",\"args\":{\"name\":\"";
+            writeString(copy.threadName);
+            *out << "\"}},\n";
+        }
+        for(size_t j=0; j<copy.events.size(); ++j) {
+            TraceEvent const & event = copy.events[j];
+            *out << "{\"name\":\"" << operationNames[event.operation]
+                 << "\",\"cat\":\"pvDatabase\",\"ph\":\"X\",\"pid\":1,\"tid\":" << copy.tid
+                 << ",\"ts\":" << event.start/1000 << '.' << (event.start%1000)/100
+                 << ",\"dur\":" << (event.end-event.start)/1000 << '.'
+                 << ((event.end-event.start)%1000)/100
+                 << ",\"args\":{\"record\":\"";
+            writeString(names[event.traceId]);
+            *out << "\"}},\n";
+        }
+    }
+    out->flush();
+}
+
+class Drainer :
+    public epicsThreadRunable
+{
+public:
+    Drainer()
+    : thread(*this,"pvDatabaseTraceLog",
+        epicsThreadGetStackSize(epicsThreadStackSmall),
+        epicsThreadPriorityLow),
+      stopping(false)
+    {
+        thread.start();
+    }
+    virtual ~Drainer()
+    {
+        {
+            epicsGuard<epics::pvData::Mutex> guard(*traceMutex);
+            stopping = true;
+        }
+        wakeup.signal();
+        thread.exitWait();
+    }
+    virtual void run()
+    {
+        while(true) {
+            wakeup.wait(0.1);
+            bool done;
+            {
+                epicsGuard<epics::pvData::Mutex> guard(*traceMutex);
+                collect(pending,names);
+                done = stopping;
+            }
+            write(pending,names);
+            if(done) return;
+        }
+    }
+private:
+    epicsThread thread;
+    epics::pvData::Event wakeup;
+    bool stopping;
+    vector<Pending> pending;
+    std::map<uint32,string> names;
+};
+
+void retireRing(void *arg)
+{
+    epicsThreadPrivateSet(ringId,0);
+    epicsAtomicSetIntT(&static_cast<Ring *>(arg)->retired,1);
+}
+
+Ring * getRing()
+{
+    Ring *ring = static_cast<Ring *>(epicsThreadPrivateGet(ringId));
+    if(ring) return ring;
+    epicsGuard<epics::pvData::Mutex> guard(*traceMutex);
+    // a retired ring is reused once the drainer has written its events,
+    // so the drainer never sees a dangling ring.
+    for(size_t i=0; i<rings->size(); ++i) {
+        Ring *retired = (*rings)[i];
+        if(epicsAtomicGetIntT(&retired->retired)==0) continue;
+        if(retired->tail!=retired->head) continue;
+        ring = retired;
+        ring->head = ring->tail = 0;
+        ring->retired = 0;
+        break;
+    }
+    if(!ring) {
+        ring = new Ring(ringSize);
+        rings->push_back(ring);
+    }
+    ring->tid = nextTid++;
+    ring->threadName = epicsThreadGetNameSelf();
+    ring->named = false;
+    epicsThreadPrivateSet(ringId,ring);
+    epicsAtThreadExit(retireRing,ring);
+    return ring;
+}
+
+// caller holds traceMutex and no drainer exists
+void freeRetiredRings()
+{
+    size_t number = 0;
+    for(size_t i=0; i<rings->size(); ++i) {
+        Ring *ring = (*rings)[i];
+        if(epicsAtomicGetIntT(&ring->retired)!=0) {
+            delete ring;
+            continue;
+        }
+        (*rings)[number++] = ring;
+    }
+    rings->resize(number);
+}
+
+}
+
+bool TraceLog::start(string const & fileName,size_t size)
+{
+    initTrace();
+    epicsGuard<epics::pvData::Mutex> guard(*traceMutex);
+    if(out) return false;
+    std::ofstream *file = new std::ofstream(fileName.c_str());
+    if(!*file) {
+        delete file;
+        return false;
+    }
+    out = file;
+    *out << "[\n";
+    if(rings->empty() && size>0) ringSize = size;
+    drainer = new Drainer();
+    epicsAtomicSetIntT(&active,1);
+    return true;
+}
+
+void TraceLog::stop()
+{
+    initTrace();
+    Drainer *stopped;
+    {
+        epicsGuard<epics::pvData::Mutex> guard(*traceMutex);
+        if(!out) return;
+        epicsAtomicSetIntT(&active,0);
+        stopped = drainer;
+        drainer = 0;
+    }
+    // the drainer writes the last events before it exits
+    delete stopped;
+    epicsGuard<epics::pvData::Mutex> guard(*traceMutex);
+    *out << "{}]\n";
+    delete out;
+    out = 0;
+    freeRetiredRings();
+}
+
+bool TraceLog::isActive()
+{
+    return epicsAtomicGetIntT(&active)!=0;
+}
+
+void TraceLog::enableRecord(PVRecord & pvRecord,bool enable)
+{
+    initTrace();
+    epicsGuard<epics::pvData::Mutex> guard(*traceMutex);
+    if(!enable) {
+        pvRecord.traceId = 0;
+        return;
+    }
+    if(pvRecord.traceId) return;
+    uint32 traceId = nextTraceId++;
+    (*recordNames)[traceId] = pvRecord.getRecordName();
+    pvRecord.traceId = traceId;
+}
+
+size_t TraceLog::getDropped()
+{
+    return epicsAtomicGetSizeT(&dropped);
+}
+
+uint64 TraceLog::now()
+{
+    return epicsMonotonicGet();
+}
+
+void TraceLog::add(uint32 traceId,Operation operation,uint64 start)
+{
+    if(epicsAtomicGetIntT(&active)==0) return;
+    uint64 end = epicsMonotonicGet();
+    Ring *ring = getRing();
+    size_t head = ring->head;
+    size_t tail = epicsAtomicGetSizeT(&ring->tail);
+    size_t size = ring->events.size();
+    if(head-tail>=size) {
+        epicsAtomicIncrSizeT(&dropped);
+        return;
+    }
+    TraceEvent & event = ring->events[head % size];
+    event.start = start;
+    event.end = end;
+    event.traceId = traceId;
+    event.operation = operation;
+    epicsAtomicSetSizeT(&ring->head,head+1);
+}
+
+}}
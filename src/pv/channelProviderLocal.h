@@ -28,6 +28,8 @@
 
 #include <shareLib.h>
 
+struct epicsThreadPool;
+
 namespace epics { namespace pvDatabase {
 
 class ChannelProviderLocal;
@@ -135,6 +137,24 @@ public:
         epics::pvAccess::ChannelRequester::shared_pointer const &channelRequester,
         short priority,
         std::string const &address);
+    /**
+     * @brief Create channels for many records.
+     *
+     * The records are found with one call to PVDatabase::findRecords.
+     * ChannelRequester::channelCreated is called for each name, in order.
+     * @param channelNames The names of the channels desired.
+     * @param channelRequester The callback to call with each result.
+     * @param priority The priority.
+     * This is ignored.
+     * @param channels Set to the channel for each name, in the same order.
+     * A name that is not found gives a null channel.
+     * @return The number of channels that were created.
+     */
+    std::size_t createChannels(
+        std::vector<std::string> const &channelNames,
+        epics::pvAccess::ChannelRequester::shared_pointer const &channelRequester,
+        short priority,
+        std::vector<epics::pvAccess::Channel::shared_pointer> &channels);
     /**
      * @brief get trace level (0,1,2) means (nothing,lifetime,process)
      * @return the level
@@ -158,8 +178,13 @@ public:
     virtual void cancel() {}
 private:
     friend epicsShareFunc ChannelProviderLocalPtr getChannelProviderLocal();
+    friend class ChannelProcessLocal;
+    epicsThreadPool * getThreadPool();
     PVDatabaseWPtr pvDatabase;
     int traceLevel;
+    // the shared pool for async process, held until the provider is destroyed
+    epicsThreadPool * threadPool;
+    epics::pvData::Mutex mutex;
     friend class ChannelProviderLocalRun;
 };
 
@@ -357,9 +382,11 @@ protected:
         return shared_from_this();
     }
 private:
+    friend class ChannelProviderLocal;
     epics::pvAccess::ChannelRequester::shared_pointer requester;
     ChannelProviderLocalWPtr provider;
     PVRecordWPtr pvRecord;
+    std::size_t clientHandle;
     epics::pvData::Mutex mutex;
 };
 
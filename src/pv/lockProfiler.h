@@ -0,0 +1,165 @@
+/* lockProfiler.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+#ifndef LOCKPROFILER_H
+#define LOCKPROFILER_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <pv/lock.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvDatabase {
+
+/**
+ * @brief Measures how long the record locks and the database lock are waited for and held.
+ *
+ * Profiling is off until enable is called.
+ * When enabled, one acquisition in sampleInterval of each thread is timed.
+ * Each sample is charged to the lock name, which is the record name for a record lock,
+ * and to the site that the calling thread declared with a LockProfiler::Scope.
+ * @author mrk
+ */
+class epicsShareClass LockProfiler {
+public:
+    /**
+     * @brief The code that takes a lock.
+     */
+    enum Site {
+        other,
+        channelGet,
+        channelPut,
+        channelPutGet,
+        channelArray,
+        channelProcess,
+        monitorStart,
+        scan,
+        numberSites
+    };
+    /**
+     * @brief The statistics for one lock name and site.
+     * Times are in seconds.
+     */
+    struct Entry {
+        std::string lockName;
+        Site site;
+        std::size_t samples;
+        double totalWait;
+        double maxWait;
+        double totalHold;
+        double maxHold;
+    };
+    /**
+     * @brief Start profiling.
+     * @param sampleInterval Time one acquisition in sampleInterval. 1 times every acquisition.
+     */
+    static void enable(unsigned int sampleInterval = 16);
+    /**
+     * @brief Stop profiling. The statistics are kept.
+     */
+    static void disable();
+    /**
+     * @brief Is profiling enabled?
+     * @return (false,true) if (disabled,enabled).
+     */
+    static bool isEnabled();
+    /**
+     * @brief Discard the statistics.
+     */
+    static void clear();
+    /**
+     * @brief Get the name of a site.
+     * @param site The site.
+     * @return The name.
+     */
+    static const char * getSiteName(Site site);
+    /**
+     * @brief Get the site set by the innermost Scope of the calling thread.
+     * @return The site. other if there is no Scope.
+     */
+    static Site getSite();
+    /**
+     * @brief Get the entries with the largest total time.
+     * @param number The maximum number of entries.
+     * @param byHold Sort by (wait,hold) time if (false,true).
+     * @return The entries in decreasing order.
+     */
+    static std::vector<Entry> getTop(std::size_t number,bool byHold);
+    /**
+     * @brief Print the top entries by wait and by hold time.
+     * @param out The stream.
+     * @param number The number of entries of each list.
+     */
+    static void report(std::ostream & out,std::size_t number);
+    /**
+     * @brief Write the statistics in folded stack format for flame graph tools.
+     *
+     * Each line is "wait;site;lockName microseconds" or "hold;site;lockName microseconds".
+     * @param fileName The file.
+     * @return (false,true) if the file (could not, could) be written.
+     */
+    static bool dumpFolded(std::string const & fileName);
+    /**
+     * @brief Declare the site for the locks taken by the calling thread while the object exists.
+     *
+     * Does nothing if the profiler is disabled when the object is created.
+     */
+    class epicsShareClass Scope {
+    public:
+        explicit Scope(Site site);
+        ~Scope();
+    private:
+        Scope(Scope const &);
+        Scope & operator=(Scope const &);
+        Site previous;
+        bool active;
+    };
+    /**
+     * @brief A guard for an epics::pvData::Mutex that is profiled with a fixed lock name.
+     */
+    class epicsShareClass MutexGuard {
+    public:
+        MutexGuard(epics::pvData::Mutex & mutex,const char * lockName);
+        ~MutexGuard();
+    private:
+        MutexGuard(MutexGuard const &);
+        MutexGuard & operator=(MutexGuard const &);
+        epics::pvData::Mutex & mutex;
+        const char * lockName;
+        epics::pvData::uint64 start;
+        epics::pvData::uint64 wait;
+        Site site;
+    };
+    /**
+     * @brief Should this acquisition be timed. Used by PVRecord.
+     * @return (false,true) if it (should not,should) be timed.
+     */
+    static bool sample();
+    /**
+     * @brief Add a sample. Used by PVRecord.
+     * @param lockName The lock name.
+     * @param site The site.
+     * @param wait The wait time in nanoseconds.
+     * @param hold The hold time in nanoseconds.
+     */
+    static void addSample(
+        std::string const & lockName,
+        Site site,
+        epics::pvData::uint64 wait,
+        epics::pvData::uint64 hold);
+private:
+    LockProfiler();
+};
+
+}}
+
+#endif  /* LOCKPROFILER_H */
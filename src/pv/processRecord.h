@@ -47,6 +47,19 @@ public:
      */
     static ProcessRecordPtr create(
         std::string const & recordName,double delay);
+    /**
+     * Factory methods to create ProcessRecord with a thread that runs on selected CPUs.
+     * @param recordName The name for the ProcessRecord.
+     * @param delay Delay time to wait between process requests.
+     * @param cpuList The CPUs the thread may run on, for example "0-3,8".
+     * An empty string means no restriction.
+     * Only supported on Linux, elsewhere cpuList is ignored.
+     * A list that does not parse, for example "1x", leaves the thread unpinned.
+     * @return A shared pointer to ProcessRecord.
+     */
+    static ProcessRecordPtr create(
+        std::string const & recordName,double delay,
+        std::string const & cpuList);
     /**
      * standard init method required by PVRecord
      * @return true unless record name already exists.
@@ -71,8 +84,11 @@ public:
 private:
     ProcessRecord(
         std::string const & recordName,
-        epics::pvData::PVStructurePtr const & pvStructure,double delay);
+        epics::pvData::PVStructurePtr const & pvStructure,double delay,
+        std::string const & cpuList);
+    void setAffinity();
     double delay;
+    std::string cpuList;
     EpicsThreadPtr thread;
     epics::pvData::Event runStop;
     epics::pvData::Event runReturn;
@@ -95,6 +95,20 @@ public:
      * @return The name.
      */
     std::string getName();
+    /**
+     * Make copyArray a slice of the frozen buffer of masterArray, without copying elements.
+     * The buffer stays shared until the master is modified.
+     * @param copyArray The array that gets the slice.
+     * @param masterArray The array that is sliced.
+     * @param offset The first element.
+     * @param count The number of elements.
+     * @return (false,true) if the arrays (have different element types, now share the slice).
+     */
+    static bool shareSubArray(
+        epics::pvData::PVScalarArray & copyArray,
+        epics::pvData::PVScalarArray const & masterArray,
+        std::size_t offset,
+        std::size_t count);
 };
 
 }}
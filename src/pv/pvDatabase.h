@@ -8,8 +8,10 @@
 
 #include <list>
 #include <map>
+#include <vector>
 
 #include <pv/pvData.h>
+#include <pv/event.h>
 #include <pv/pvTimeStamp.h>
 #include <pv/rpcService.h>
 #include <pv/pvStructureCopy.h>
@@ -44,6 +46,16 @@ class PVDatabase;
 typedef std::tr1::shared_ptr<PVDatabase> PVDatabasePtr;
 typedef std::tr1::weak_ptr<PVDatabase> PVDatabaseWPtr;
 
+class PVRecordReaper;
+typedef std::tr1::shared_ptr<PVRecordReaper> PVRecordReaperPtr;
+
+class RecordNameFilter;
+
+class PVRecordPool;
+typedef std::tr1::shared_ptr<PVRecordPool> PVRecordPoolPtr;
+
+class TraceLog;
+
 /**
  * @brief Base interface for a PVRecord.
  *
@@ -83,9 +95,35 @@ public:
      *  If it encounters errors it should raise alarms and/or
      *  call the <b>message</b> method provided by the base class.
      *  If the pvStructure has a top level timeStamp,
-     *  the base class sets the timeStamp to the current time.
+     *  the base class sets the timeStamp to the current time
+     *  as given by TimeStampService.
      */
     virtual void process();
+    /**
+     * @brief Lock the record and call process in a group put.
+     *
+     * If coalescing is enabled and another thread is processing the record,
+     * the caller waits until a process that started after the call has finished.
+     * All callers that arrive while a process is running share one follow-up process.
+     * A caller runs at most its own process and one follow-up, then a waiting
+     * caller takes over, so no caller processes for others indefinitely.
+     * The caller must not hold the record lock.
+     * If process throws, every caller that shares that process gets
+     * a std::runtime_error with the message.
+     * Since the process is a group put of its own, a put followed by a coalesced
+     * process gives monitors two updates, one for the put and one for the process.
+     */
+    void processGroupPut();
+    /**
+     * @brief Enable or disable coalescing of processGroupPut calls.
+     * @param value (false,true) means (process for each call, merge concurrent calls).
+     */
+    void setCoalesceProcess(bool value);
+    /**
+     * @brief Is coalescing of processGroupPut calls enabled?
+     * @return (false,true) if (disabled,enabled).
+     */
+    bool getCoalesceProcess();
     /**
      *  @brief DEPRECATED
      */
@@ -97,8 +135,17 @@ public:
      *  get rid of listeners and requesters.
      *  If derived class overrides this then it must call PVRecord::remove()
      *  after it has destroyed any resorces it uses.
+     *  The record is taken out of the database before any client is detached.
+     *  See PVDatabase::setDeferredClientDetach.
      */
     virtual void remove();
+    /**
+     * @brief Has the record been removed from the database?
+     *
+     * A removed record accepts no new clients or listeners.
+     * @return <b>true</b> if the record has been removed.
+     */
+    bool isRemoved() const { return removed;}
     /**
      *  @brief Optional method for derived class.
      *
@@ -143,6 +190,7 @@ public:
      * @brief Find the PVRecordField for the PVField.
      *
      * This is called by the pvCopy facility.
+     * The lookup is a single index by field offset.
      * @param pvField The PVField.
      * @return The shared pointer to the PVRecordField.
      */
@@ -180,6 +228,12 @@ public:
      * @param otherRecord The other record to lock.
      */
     void lockOtherRecord(PVRecordPtr const & otherRecord);
+    /**
+     * @brief A handle that never refers to a client.
+     *
+     * A client can initialize its handle to this before it is added.
+     */
+    static const std::size_t noClientHandle = static_cast<std::size_t>(-1);
     /**
      * @brief Add a client that wants to access the record.
      *
@@ -187,8 +241,37 @@ public:
      * client can be notified when the record is deleted.
      * @param pvRecordClient The client.
      * @return <b>true</b> if the client is added.
+     * <b>false</b> is returned if the record has been removed.
      */
     bool addPVRecordClient(PVRecordClientPtr const & pvRecordClient);
+    /**
+     * @brief Add a client and return a handle for it.
+     *
+     * Just like the previous method but also returns a handle that
+     * the client can give to removePVRecordClient when it goes away,
+     * so that its slot is released without searching the client list.
+     * @param pvRecordClient The client.
+     * @param handle Set to the handle for the client.
+     * @return <b>true</b> if the client is added.
+     */
+    bool addPVRecordClient(
+        PVRecordClientPtr const & pvRecordClient,
+        std::size_t & handle);
+    /**
+     * @brief Remove a client.
+     *
+     * Nothing is done if the handle no longer refers to the client.
+     * @param handle The handle returned by addPVRecordClient.
+     * @param pvRecordClient The client.
+     */
+    void removePVRecordClient(
+        std::size_t handle,
+        PVRecordClient const * pvRecordClient);
+    /**
+     * @brief Get the number of clients.
+     * @return The number of clients that have been added and not removed.
+     */
+    std::size_t getNumberClients();
     /**
      * @brief Add a PVListener.
      *
@@ -216,6 +299,24 @@ public:
     bool removeListener(
         PVListenerPtr const & pvListener,
         epics::pvCopy::PVCopyPtr const & pvCopy);
+    /**
+     * @brief Get a PVCopy of the record for a pvRequest.
+     *
+     * A PVCopy without filters is shared by all clients that give the same
+     * pvRequest and structureName, so that a client that connects again does not
+     * build it again. The record keeps the most recently used ones until it is removed.
+     * @param pvRequest The request.
+     * @param structureName The name of the request substructure, see PVCopy::create.
+     * @return The PVCopy or null if pvRequest is not valid.
+     */
+    epics::pvCopy::PVCopyPtr getPVCopy(
+        epics::pvData::PVStructurePtr const & pvRequest,
+        std::string const & structureName);
+    /**
+     * @brief Set the number of PVCopys that getPVCopy keeps.
+     * @param size The number. 0 means that no PVCopy is shared. The default is 8.
+     */
+    void setPVCopyCacheSize(std::size_t size);
 
 
     /**
@@ -236,6 +337,11 @@ public:
      * @param level The level
      */
     void setTraceLevel(int level) {traceLevel = level;}
+    /**
+     * @brief Get the id used by TraceLog.
+     * @return The id. 0 means that TraceLog is not enabled for this record.
+     */
+    epics::pvData::uint32 getTraceId() const {return traceId;}
 protected:
     /**
      * @brief Constructor
@@ -253,25 +359,69 @@ protected:
     void initPVRecord();
 private:
     friend class PVDatabase;
+    friend class PVRecordReaper;
+    friend class PVRecordPool;
+    friend class TraceLog;
     void unlistenClients();
+    void reapClients();
+    void clearPVCopyCache();
+    void postBitSet(std::size_t fieldOffset);
+    void callBitSetListeners();
 
-    PVRecordFieldPtr findPVRecordField(
-        PVRecordStructurePtr const & pvrs,
-        epics::pvData::PVFieldPtr const & pvField);
+    void indexPVRecordField(PVRecordFieldPtr const & pvRecordField);
 
     std::string recordName;
     epics::pvData::PVStructurePtr pvStructure;
     PVRecordStructurePtr pvRecordStructure;
+    // indexed by field offset
+    std::vector<PVRecordFieldPtr> pvRecordFieldIndex;
+    // fields changed since the last call to the bitSet listeners
+    epics::pvData::BitSet changedBitSet;
     std::list<PVListenerWPtr> pvListenerList;
-    std::list<PVRecordClientWPtr> clientList;
+    // clients are kept in slots that are reused via clientFreeList.
+    // A handle is the index of the slot.
+    struct ClientSlot {
+        PVRecordClientWPtr client;
+        PVRecordClient const * id;
+    };
+    std::vector<ClientSlot> clientList;
+    std::vector<std::size_t> clientFreeList;
+    std::size_t clientReapThreshold;
     epics::pvData::Mutex mutex;
+    // (request key,PVCopy) of getPVCopy, most recently used first
+    std::list<std::pair<std::string,epics::pvCopy::PVCopyPtr> > pvCopyCache;
+    std::size_t pvCopyCacheSize;
+    epics::pvData::Mutex pvCopyCacheMutex;
+    // state of processGroupPut when coalescing is enabled
+    struct ProcessWaiter {
+        epics::pvData::uint64 number;
+        epics::pvData::Event event;
+        std::string error;
+        // set when processRunning is handed to this waiter
+        bool run;
+    };
+    bool coalesceProcess;
+    bool processRunning;
+    epics::pvData::uint64 processStarted;
+    std::vector<ProcessWaiter *> processWaiters;
+    epics::pvData::Mutex processMutex;
     std::size_t depthGroupPut;
     int traceLevel;
+    epics::pvData::uint32 traceId;
+    epics::pvData::uint64 groupPutStart;
+    // following are used for LockProfiler and are only changed while locked.
+    std::size_t lockDepth;
+    epics::pvData::uint64 lockStart;
+    epics::pvData::uint64 lockWait;
+    int lockSite;
+    bool removed;
+    bool pooled;
     // following only valid while addListener or removeListener is active.
     bool isAddListener;
     PVListenerWPtr pvListener;
 
-    epics::pvData::PVTimeStamp pvTimeStamp;
+    epics::pvData::PVLongPtr pvSecondsPastEpoch;
+    epics::pvData::PVIntPtr pvNanoseconds;
     epics::pvData::TimeStamp timeStamp;
 };
 
@@ -344,16 +494,25 @@ private:
     bool addListener(PVListenerPtr const & pvListener);
     virtual void removeListener(PVListenerPtr const & pvListener);
     void callListener();
+    void rebind(PVRecordPtr const & pvRecord);
+    void updateListenerCounts(bool add,bool bitSet);
+    void updateAncestorListeners(bool add,bool bitSet);
 
     std::list<PVListenerWPtr> pvListenerList;
+    // listeners on the fields above this field
+    std::size_t ancestorListeners;
+    // listeners on this field and the fields below it
+    std::size_t subtreeListeners;
+    // bitSet listeners on this field, the fields above or the fields below
+    std::size_t bitSetListeners;
+    std::size_t fieldOffset;
     epics::pvData::PVField::weak_pointer pvField;
     bool isStructure;
     PVRecordStructureWPtr parent;
     PVRecordWPtr pvRecord;
-    std::string fullName;
-    std::string fullFieldName;
     friend class PVRecordStructure;
     friend class PVRecord;
+    friend class PVRecordPool;
 };
 
 /**
@@ -450,6 +609,28 @@ public:
     virtual void dataPut(
         PVRecordStructurePtr const & requested,
         PVRecordFieldPtr const & pvRecordField) = 0;
+    /**
+     * @brief Does the listener want the changed fields as one bitSet.
+     *
+     * If true the record does not call the other dataPut methods.
+     * Instead the record accumulates the changes of a group put and calls
+     * dataPut(pvRecord,changed) once before endGroupPut.
+     * A put outside a group put is delivered at once.
+     * The answer must not change while the listener is added to the record.
+     * @return The default is false.
+     */
+    virtual bool isBitSetListener() { return false;}
+    /**
+     * @brief Fields have been modified.
+     *
+     * Called only for listeners that return true for isBitSetListener.
+     * @param pvRecord The record.
+     * @param changed A bit for each modified field, indexed by offset in the record's top level
+     * PVStructure. Only fields that can be seen by at least one listener are set.
+     */
+    virtual void dataPut(
+        PVRecordPtr const & pvRecord,
+        epics::pvData::BitSet const & changed) {}
     /**
      * @brief Begin a set of puts.
      * @param pvRecord The record.
@@ -491,6 +672,19 @@ public:
      * @return The shared pointer.
      */
     PVRecordPtr findRecord(std::string const& recordName);
+    /**
+     * @brief Find many records.
+     *
+     * The names are checked with the name filter, sorted, and looked up while the
+     * lock is held once. A name that appears more than once is looked up once.
+     * @param recordNames The names of the records.
+     * @param records Set to the record for each name, in the same order.
+     * A name that is not found gives a null record.
+     * @return The number of names that were found.
+     */
+    std::size_t findRecords(
+        std::vector<std::string> const & recordNames,
+        std::vector<PVRecordPtr> & records);
     /**
      * @brief Add a record.
      *
@@ -500,28 +694,203 @@ public:
     bool addRecord(PVRecordPtr const & record);
     /**
      * @brief Remove a record.
+     *
+     * The record is removed from the database and then
+     * its listeners and clients are detached.
      * @param record The record to remove.
      *
      * @return <b>true</b> if record was removed.
      */
     bool removeRecord(PVRecordPtr const & record);
+    /**
+     * @brief Set how the clients of a removed record are detached.
+     *
+     * By default every PVListener::unlisten and PVRecordClient::detach
+     * is called before removeRecord or PVRecord::remove returns.
+     * If deferred, they are called by a low priority reaper thread.
+     * A removed record accepts no new clients in either case.
+     * @param value (false,true) means detach (before returning, deferred).
+     */
+    void setDeferredClientDetach(bool value);
+    /**
+     * @brief Are the clients of a removed record detached by the reaper thread?
+     * @return The value given to setDeferredClientDetach.
+     */
+    bool getDeferredClientDetach();
     /**
      * @brief Get the names of all the records in the database.
+     * @param includeAliases Also return the alias names.
      * @return The names.
      */
-    epics::pvData::PVStringArrayPtr getRecordNames();
+    epics::pvData::PVStringArrayPtr getRecordNames(bool includeAliases = false);
+    /**
+     * @brief Add an alias for a record.
+     *
+     * findRecord returns the record for the alias name.
+     * @param aliasName The alias name.
+     * @param recordName The name of the record, or of another alias of the record.
+     * @return (false,true) if the alias (was not, was) added.
+     * It is not added if the name is already used or the record is not found.
+     */
+    bool addAlias(std::string const & aliasName,std::string const & recordName);
+    /**
+     * @brief Add many aliases.
+     *
+     * Either all or none of the aliases are added, while the lock is held once.
+     * @param aliasNames The alias names.
+     * @param recordNames The record name for each alias name.
+     * @return (false,true) if the aliases (were not, were) added.
+     */
+    bool addAliases(
+        std::vector<std::string> const & aliasNames,
+        std::vector<std::string> const & recordNames);
+    /**
+     * @brief Remove many aliases.
+     *
+     * Either all or none of the aliases are removed.
+     * Channels that were created via an alias are not affected.
+     * The aliases of a record are also removed when the record is removed.
+     * @param aliasNames The alias names.
+     * @return (false,true) if the aliases (were not, were) removed.
+     */
+    bool removeAliases(std::vector<std::string> const & aliasNames);
+    /**
+     * @brief Get the statistics of findRecord.
+     *
+     * findRecord first checks a Bloom filter of the record names,
+     * which rejects most names that are not in the database without a lock.
+     * @param hits Set to the number of names that were found.
+     * @param misses Set to the number of names that were not found.
+     * @param filtered Set to the number of misses that were rejected by the filter.
+     */
+    void getFindStatistics(
+        std::size_t & hits,std::size_t & misses,std::size_t & filtered);
+    /**
+     * @brief Set the statistics of findRecord to 0.
+     */
+    void clearFindStatistics();
+    /**
+     * @brief Get the generation of the record names.
+     *
+     * The generation changes each time a record or an alias is added or removed,
+     * so a caller that caches the result of a search can tell when to search again.
+     * @return The generation.
+     */
+    std::size_t getGeneration();
 private:
     friend class PVRecord;
 
     PVRecordWPtr removeFromMap(PVRecordPtr const & record);
+    void detachClients(PVRecordPtr const & record);
     PVDatabase();
     void lock();
     void unlock();
+    void addName(std::string const & name);
+    void removeName(std::string const & name);
+    // has an entry for each record name and each alias name
     PVRecordMap  recordMap;
+    // alias name to record name
+    std::map<std::string,std::string> aliasMap;
+    typedef std::multimap<std::string,std::string> AliasMultiMap;
+    // record name to alias name, so that removing a record finds its aliases
+    AliasMultiMap recordAliases;
+    // the filter used by findRecord, read without the lock
+    RecordNameFilter * nameFilter;
+    // every filter that was used, so that a reader never sees a deleted one.
+    // Each is at least twice the size of the one it replaced, so together the replaced
+    // filters are smaller than the current one.
+    std::vector<std::tr1::shared_ptr<RecordNameFilter> > nameFilters;
+    std::size_t numberNames;
+    std::size_t findHits;
+    std::size_t findMisses;
+    std::size_t findFiltered;
+    std::size_t generation;
+    bool deferredClientDetach;
+    PVRecordReaperPtr reaper;
     epics::pvData::Mutex mutex;
     static bool getMasterFirstCall;
 };
 
+/**
+ * @brief A pool of top level PVStructures for records that are created and removed often.
+ *
+ * A record whose PVStructure was created by the pool gives the
+ * PVStructure and its PVRecordField tree back to the pool when the record
+ * is destroyed, provided that nothing else still holds the PVStructure.
+ * The next call to createPVStructure for the same Structure resets
+ * the fields to their initial values and returns it.
+ * PVRecord::initPVRecord then binds the existing PVRecordField tree to
+ * the new record instead of creating a new one.
+ * Code that keeps a subfield of a removed record must not modify it.
+ * @author mrk
+ */
+class epicsShareClass PVRecordPool {
+public:
+    POINTER_DEFINITIONS(PVRecordPool);
+    /**
+     * @brief Get the pool.
+     * @return The shared pointer.
+     */
+    static PVRecordPoolPtr getPool();
+    /**
+     * @brief Destructor
+     */
+    virtual ~PVRecordPool();
+    /**
+     * @brief Create a top level PVStructure for a new record.
+     *
+     * @param structure The introspection interface.
+     * @return A recycled PVStructure with initial values or a new PVStructure.
+     */
+    epics::pvData::PVStructurePtr createPVStructure(
+        epics::pvData::StructureConstPtr const & structure);
+    /**
+     * @brief Set the maximum number of free PVStructures kept for each Structure.
+     * @param maxFree The maximum. 0 means that nothing is recycled.
+     */
+    void setMaxFree(std::size_t maxFree);
+    /**
+     * @brief Get the number of free PVStructures for a Structure.
+     * @param structure The introspection interface.
+     * @return The number.
+     */
+    std::size_t getNumberFree(epics::pvData::StructureConstPtr const & structure);
+    /**
+     * @brief Release all free PVStructures.
+     */
+    void clear();
+private:
+    friend class PVRecord;
+    struct FreeEntry {
+        epics::pvData::PVStructurePtr pvStructure;
+        PVRecordStructurePtr pvRecordStructure;
+    };
+    struct StructureEntry {
+        epics::pvData::PVStructurePtr initial;
+        std::vector<FreeEntry> freeList;
+    };
+    struct Allocated {
+        epics::pvData::PVStructure::weak_pointer pvStructure;
+        PVRecordStructurePtr pvRecordStructure;
+    };
+    typedef std::map<epics::pvData::StructureConstPtr,StructureEntry> StructureMap;
+    typedef std::map<const epics::pvData::PVStructure *,Allocated> AllocatedMap;
+
+    PVRecordPool();
+    static void createPool(void *);
+    bool takePVRecordStructure(
+        epics::pvData::PVStructurePtr const & pvStructure,
+        PVRecordStructurePtr & pvRecordStructure);
+    void release(
+        epics::pvData::PVStructurePtr const & pvStructure,
+        PVRecordStructurePtr const & pvRecordStructure);
+
+    StructureMap structureMap;
+    AllocatedMap allocatedMap;
+    std::size_t maxFree;
+    epics::pvData::Mutex mutex;
+};
+
 }}
 
 #endif  /* PVDATABASE_H */
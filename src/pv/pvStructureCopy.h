@@ -13,6 +13,7 @@
 #include <string>
 #include <stdexcept>
 #include <memory>
+#include <vector>
 #include <pv/pvData.h>
 #include <pv/bitSet.h>
 
@@ -168,6 +169,23 @@ public:
      *  name is the subField name and value is the subField value.
      */
     epics::pvData::PVStructurePtr getOptions(std::size_t fieldOffset);
+    /**
+     * For each set bit in masterBitSet set the bits in copyBitSet for the fields of
+     * the copy that see the change.
+     * A bit for a field that is an ancestor of copied fields sets the bits of all those fields.
+     * This uses a table built when the PVCopy is created.
+     * @param masterBitSet A bitSet with a bit for each changed field of pvMaster.
+     * @param copyBitSet A bitSet for a copy top-level structure.
+     */
+    void mapMasterBitSet(
+        epics::pvData::BitSet const &masterBitSet,
+        epics::pvData::BitSet &copyBitSet);
+    /**
+     * Does any field of the copy have a filter plugin?
+     * A PVCopy without filters keeps no state of its own and can be shared by clients.
+     * @returns (false,true) if (no field, a field) has a filter.
+     */
+    bool hasFilters() const {return filtered;}
     /**
      * For debugging.
      */
@@ -184,6 +202,15 @@ private:
     CopyNodePtr headNode;
     epics::pvData::PVStructurePtr cacheInitStructure;
     epics::pvData::BitSetPtr ignorechangeBitSet;
+    bool filtered;
+    // indexed by master offset relative to pvMaster
+    struct MasterOffset {
+        std::size_t copyOffset;
+        std::size_t nextOffset;
+    };
+    std::vector<MasterOffset> masterOffsets;
+    // (master offset,copy offset) of each copy node sorted by master offset
+    std::vector<std::pair<std::size_t,std::size_t> > copyNodeOffsets;
 
     void traverseMaster(
         CopyNodePtr const &node,
@@ -226,6 +253,8 @@ private:
         epics::pvData::PVFieldPtr const & pvMasterField);
     void traverseMasterInitPlugin();
     void traverseMasterInitPlugin(CopyNodePtr const & node);
+    void initMasterOffsets();
+    void initMasterOffsets(CopyNodePtr const & node);
 
     CopyNodePtr getCopyOffset(
         CopyStructureNodePtr const &structureNode,
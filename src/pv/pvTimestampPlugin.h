@@ -57,6 +57,10 @@ public:
 
 /**
  * @brief  A filter that sets a timeStamp to/from the current field or pvCopy.
+ *
+ * The master timeStamp is attached once when the filter is created.
+ * For timestamp=current the time comes from pvDatabase::TimeStampService,
+ * so every subscriber updated by the same group put gets the same timestamp.
  */
 class epicsShareClass PVTimestampFilter : public PVFilter
 {
@@ -66,9 +70,15 @@ private:
     bool current;
     bool copy;
     epics::pvData::PVFieldPtr master;
+    epics::pvData::PVTimeStamp pvMasterTimeStamp;
+    std::size_t secondsIndex;
+    std::size_t nanosecondsIndex;
+    std::size_t userTagIndex;
 
 
     PVTimestampFilter(bool current,bool copy,epics::pvData::PVFieldPtr const & pvField);
+    bool getCopy(epics::pvData::PVFieldPtr const & pvCopy);
+    bool putCopy(epics::pvData::PVFieldPtr const & pvCopy);
 public:
     POINTER_DEFINITIONS(PVTimestampFilter);
     virtual ~PVTimestampFilter();
@@ -0,0 +1,159 @@
+/* snapshotRecord.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+#ifndef SNAPSHOTRECORD_H
+#define SNAPSHOTRECORD_H
+
+#include <vector>
+#include <epicsThread.h>
+#include <pv/event.h>
+#include <pv/channelProviderLocal.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvDatabase {
+
+class SnapshotRecord;
+typedef std::tr1::shared_ptr<SnapshotRecord> SnapshotRecordPtr;
+
+/**
+ * @brief Take a snapshot of a scalar field of many records.
+ *
+ * The argument has two fields: pattern and fieldName.
+ * pattern is a comma separated list of record names, which can contain the
+ * glob characters * and ?.
+ * fieldName is the scalar field of each record, for example value.
+ * The result has a field status and the parallel arrays names, values,
+ * severities, secondsPastEpoch and nanoseconds.
+ * Each record is locked only while its fields are copied.
+ * The records that match the pattern are found again when the pattern or fieldName
+ * changes, or when a record or alias is added to or removed from the master database.
+ *
+ * A snapshot is taken when the record is processed, for example via a
+ * channelPutGet request, and, if period is greater than 0, every period seconds,
+ * so that clients can monitor the record.
+ * The record also supports channelRPC, with the arguments pattern and fieldName,
+ * which returns the snapshot as an NTTable.
+ */
+class epicsShareClass SnapshotRecord :
+    public PVRecord,
+    public epicsThreadRunable
+{
+public:
+    POINTER_DEFINITIONS(SnapshotRecord);
+    /**
+     * @brief The columns of a snapshot.
+     */
+    struct Snapshot {
+        std::vector<std::string> names;
+        std::vector<double> values;
+        std::vector<epics::pvData::int32> severities;
+        std::vector<epics::pvData::int64> secondsPastEpoch;
+        std::vector<epics::pvData::int32> nanoseconds;
+    };
+    /**
+     * Factory method to create SnapshotRecord.
+     * @param recordName The name for the SnapshotRecord.
+     * @param period The time in seconds between periodic snapshots. 0 means no periodic snapshots.
+     * @return A shared pointer to SnapshotRecord.
+     */
+    static SnapshotRecordPtr create(
+        std::string const & recordName,double period = 0.0);
+    /**
+     * @brief Destructor
+     */
+    virtual ~SnapshotRecord();
+    /**
+     * standard init method required by PVRecord
+     * @return true unless record name already exists.
+     */
+    virtual bool init();
+    /**
+     * @brief Take a snapshot with the current argument.
+     */
+    virtual void process();
+    /**
+     * @brief Get the service for channelRPC.
+     * @param pvRequest The request.
+     * @return The service.
+     */
+    virtual epics::pvAccess::RPCServiceAsync::shared_pointer getService(
+        epics::pvData::PVStructurePtr const & pvRequest);
+    /**
+     * @brief The run method for the periodic thread.
+     */
+    virtual void run();
+    /**
+     * @brief Stop the periodic thread.
+     */
+    void stop();
+    /**
+     * @brief Take a snapshot of the records in the master database.
+     * @param pattern The comma separated record names or glob patterns.
+     * @param fieldName The scalar field.
+     * @param snapshot The result.
+     * @return An empty string or an error message.
+     */
+    static std::string takeSnapshot(
+        std::string const & pattern,
+        std::string const & fieldName,
+        Snapshot & snapshot);
+private:
+    struct Entry {
+        PVRecordWPtr pvRecord;
+        epics::pvData::PVScalarPtr pvValue;
+        epics::pvData::PVIntPtr pvSeverity;
+        epics::pvData::PVLongPtr pvSecondsPastEpoch;
+        epics::pvData::PVIntPtr pvNanoseconds;
+    };
+    SnapshotRecord(
+        std::string const & recordName,
+        epics::pvData::PVStructurePtr const & pvStructure,double period);
+    static std::string findEntries(
+        std::string const & pattern,
+        std::string const & fieldName,
+        std::string const & skipName,
+        std::vector<std::string> & names,
+        std::vector<Entry> & entries);
+    static void copyEntries(
+        std::vector<Entry> const & entries,
+        Snapshot & snapshot,
+        PVRecordPtr const & lockedRecord);
+    std::string update(
+        std::string const & pattern,
+        std::string const & fieldName,
+        Snapshot & snapshot,
+        PVRecordPtr const & lockedRecord);
+    void publish(std::string const & status,Snapshot const & snapshot);
+    double period;
+    std::tr1::shared_ptr<epicsThread> thread;
+    epics::pvData::Event runStop;
+    epics::pvData::Event runReturn;
+    epics::pvData::PVStringPtr pvPattern;
+    epics::pvData::PVStringPtr pvFieldName;
+    epics::pvData::PVStringPtr pvStatus;
+    epics::pvData::PVStringArrayPtr pvNames;
+    epics::pvData::PVDoubleArrayPtr pvValues;
+    epics::pvData::PVIntArrayPtr pvSeverities;
+    epics::pvData::PVLongArrayPtr pvSecondsPastEpoch;
+    epics::pvData::PVIntArrayPtr pvNanoseconds;
+    // the entries of the last pattern and fieldName, reused while the database is unchanged.
+    // mutex is never held while a record is locked.
+    epics::pvData::Mutex mutex;
+    std::string lastPattern;
+    std::string lastFieldName;
+    std::size_t lastGeneration;
+    std::vector<std::string> names;
+    std::vector<Entry> entries;
+};
+
+}}
+
+#endif  /* SNAPSHOTRECORD_H */
@@ -0,0 +1,87 @@
+/* timeStampService.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+#ifndef TIMESTAMPSERVICE_H
+#define TIMESTAMPSERVICE_H
+
+#include <pv/timeStamp.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvDatabase {
+
+/**
+ * @brief The clock used by the database to timestamp records.
+ *
+ * Code that processes many records at once, for example a scan,
+ * opens a batch. Within a batch a thread reads the clock only once
+ * and every record processed by that thread gets the same timestamp.
+ * Outside a batch, or in mode perCall, each call reads the clock.
+ * The timestamps issued to a thread are never earlier than a timestamp
+ * already issued to that thread, even if the system clock is stepped back.
+ * No lock is taken, so threads processing records do not serialize here.
+ * @author mrk
+ */
+class epicsShareClass TimeStampService {
+public:
+    /**
+     * @brief How getCurrent reads the clock.
+     */
+    enum Mode {
+        /** Read the clock on every call, for full resolution. */
+        perCall,
+        /** Read the clock once per batch. This is the default. */
+        batch
+    };
+    /**
+     * @brief Get the current time.
+     *
+     * Only the seconds and nanoseconds are set, the userTag is unchanged.
+     * @param timeStamp The timestamp to set.
+     */
+    static void getCurrent(epics::pvData::TimeStamp & timeStamp);
+    /**
+     * @brief Start a batch for the calling thread.
+     *
+     * Batches nest. The cached time is discarded when the outermost batch ends.
+     */
+    static void beginBatch();
+    /**
+     * @brief End a batch for the calling thread.
+     */
+    static void endBatch();
+    /**
+     * @brief Set the mode for all threads.
+     * @param mode The mode.
+     */
+    static void setMode(Mode mode);
+    /**
+     * @brief Get the mode.
+     * @return The mode.
+     */
+    static Mode getMode();
+    /**
+     * @brief A batch that lasts for the lifetime of the object.
+     */
+    class Batch {
+    public:
+        Batch() { TimeStampService::beginBatch();}
+        ~Batch() { TimeStampService::endBatch();}
+    private:
+        Batch(Batch const &);
+        Batch & operator=(Batch const &);
+    };
+private:
+    TimeStampService();
+};
+
+}}
+
+#endif  /* TIMESTAMPSERVICE_H */
@@ -0,0 +1,123 @@
+/* traceLog.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+#ifndef TRACELOG_H
+#define TRACELOG_H
+
+#include <string>
+#include <pv/pvType.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvDatabase {
+
+class PVRecord;
+
+/**
+ * @brief Structured tracing of record activity.
+ *
+ * An alternative to the cout output of PVRecord::setTraceLevel that does not
+ * change the timing of the traced code.
+ * Each thread writes binary events into its own lock free ring buffer.
+ * A low priority thread drains the rings and writes the events to a file in
+ * Chrome trace event JSON format, which can be viewed with chrome://tracing or Perfetto.
+ * Events are written only for records enabled by enableRecord,
+ * for example via TraceRecord.
+ * If a ring is full, new events are dropped and counted.
+ * When an epicsThread exits its ring is given to the next thread that traces,
+ * and stop frees the rings of threads that have exited.
+ * The drainer copies the events under its lock and writes the file after releasing it,
+ * so getting a ring for a new thread never waits for file I/O.
+ * @author mrk
+ */
+class epicsShareClass TraceLog {
+public:
+    /**
+     * @brief The traced operations.
+     */
+    enum Operation {
+        groupPut,
+        channelGet,
+        channelPut,
+        channelPutGet,
+        channelArray,
+        channelProcess,
+        monitorEvent,
+        numberOperations
+    };
+    /**
+     * @brief Start writing events.
+     * @param fileName The output file.
+     * @param ringSize The number of events each thread can buffer.
+     * @return (false,true) if (already started or file could not be opened, started).
+     */
+    static bool start(std::string const & fileName,std::size_t ringSize = 8192);
+    /**
+     * @brief Write the remaining events and close the file.
+     */
+    static void stop();
+    /**
+     * @brief Is an output file open?
+     * @return (false,true) if (no, yes).
+     */
+    static bool isActive();
+    /**
+     * @brief Enable or disable the events for a record.
+     * @param pvRecord The record.
+     * @param enable (false,true) means (disable,enable).
+     */
+    static void enableRecord(PVRecord & pvRecord,bool enable);
+    /**
+     * @brief Get the number of events dropped because a ring was full.
+     * @return The number.
+     */
+    static std::size_t getDropped();
+    /**
+     * @brief Get the time used for events.
+     * @return Monotonic time in nanoseconds.
+     */
+    static epics::pvData::uint64 now();
+    /**
+     * @brief Add an event for the calling thread.
+     * @param traceId The id given to the record by enableRecord.
+     * @param operation The operation.
+     * @param start The start time given by now().
+     */
+    static void add(
+        epics::pvData::uint32 traceId,
+        Operation operation,
+        epics::pvData::uint64 start);
+    /**
+     * @brief An event that lasts for the lifetime of the object.
+     *
+     * Nothing is done if the record is not enabled.
+     */
+    class Span {
+    public:
+        Span(epics::pvData::uint32 traceId,Operation operation)
+        : traceId(traceId),
+          operation(operation),
+          start(traceId ? now() : 0)
+        {}
+        ~Span() { if(traceId) add(traceId,operation,start);}
+    private:
+        Span(Span const &);
+        Span & operator=(Span const &);
+        epics::pvData::uint32 traceId;
+        Operation operation;
+        epics::pvData::uint64 start;
+    };
+private:
+    TraceLog();
+};
+
+}}
+
+#endif  /* TRACELOG_H */
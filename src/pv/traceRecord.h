@@ -27,7 +27,8 @@ typedef std::tr1::shared_ptr<TraceRecord> TraceRecordPtr;
  *
  * A record to set the trace value for another record
  * It is meant to be used via a channelPutGet request.
- * The argument has two fields: recordName and  level.
+ * The argument has the fields recordName, level and structured.
+ * If structured is true the record is also enabled for TraceLog.
  * The result has a field named status.
  */
 class epicsShareClass TraceRecord :
@@ -58,6 +59,7 @@ private:
         epics::pvData::PVStructurePtr const & pvStructure);
     epics::pvData::PVStringPtr pvRecordName;
     epics::pvData::PVIntPtr pvLevel;
+    epics::pvData::PVBooleanPtr pvStructured;
     epics::pvData::PVStringPtr pvResult;
 };
 
@@ -0,0 +1,145 @@
+/* workloadRecorder.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+#ifndef WORKLOADRECORDER_H
+#define WORKLOADRECORDER_H
+
+#include <string>
+#include <istream>
+#include <pv/pvData.h>
+#include <pv/bitSet.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvDatabase {
+
+class PVRecord;
+
+/**
+ * @brief Captures the channel operations done via ChannelProviderLocal.
+ *
+ * While started, each channel create, get, put, process and monitor create
+ * is written to a file as one line of tab separated fields:
+ *
+ *     microseconds client operation channelName request value
+ *
+ * microseconds is the time since start. client numbers, from 1, the threads
+ * that called the provider, which for a pvAccess server are its client
+ * connections. request is the pvRequest as a
+ * string that CreateRequest accepts, and value is, for a put,
+ * the fields selected by the put bitSet in JSON.
+ * The first time a channel is created for a record a line with operation
+ * record gives the introspection interface of the record and its value in JSON,
+ * so that a replay can create an equivalent record.
+ * example/workloadReplay replays a capture.
+ * @author mrk
+ */
+class epicsShareClass WorkloadRecorder {
+public:
+    /**
+     * @brief The recorded operations.
+     */
+    enum Operation {
+        record,
+        createChannel,
+        get,
+        put,
+        process,
+        monitor,
+        numberOperations
+    };
+    /**
+     * @brief One line of a capture.
+     */
+    struct Event {
+        double time;
+        std::size_t client;
+        Operation operation;
+        std::string channelName;
+        std::string request;
+        std::string value;
+    };
+    /**
+     * @brief Start recording.
+     * @param fileName The capture file.
+     * @return (false,true) if (already started or file could not be opened, started).
+     */
+    static bool start(std::string const & fileName);
+    /**
+     * @brief Stop recording and close the file.
+     */
+    static void stop();
+    /**
+     * @brief Is a capture being written?
+     * @return (false,true) if (no, yes).
+     */
+    static bool isActive();
+    /**
+     * @brief Record a channel create. Used by ChannelProviderLocal.
+     * @param pvRecord The record.
+     */
+    static void addCreateChannel(PVRecord & pvRecord);
+    /**
+     * @brief Record an operation. Used by ChannelLocal.
+     * @param operation The operation.
+     * @param channelName The channel name.
+     * @param pvRequest The pvRequest of the operation.
+     * @param pvPut For a put the data sent by the client.
+     * @param putBitSet For a put the fields sent by the client.
+     */
+    static void add(
+        Operation operation,
+        std::string const & channelName,
+        epics::pvData::PVStructurePtr const & pvRequest,
+        epics::pvData::PVStructurePtr const & pvPut = epics::pvData::PVStructurePtr(),
+        epics::pvData::BitSetPtr const & putBitSet = epics::pvData::BitSetPtr());
+    /**
+     * @brief Read the next line of a capture.
+     *
+     * A line that is not valid throws std::runtime_error,
+     * with a message that gives the line number.
+     * @param in The stream.
+     * @param event The result.
+     * @param lineNumber The number of lines read so far.
+     * Start with 0 and pass the same variable to each call.
+     * @return (false,true) if (end of file, event read).
+     */
+    static bool read(std::istream & in,Event & event,std::size_t & lineNumber);
+    /**
+     * @brief Get the name of an operation.
+     * @param operation The operation.
+     * @return The name.
+     */
+    static const char * getOperationName(Operation operation);
+    /**
+     * @brief Convert a pvRequest to a string that CreateRequest accepts.
+     * @param pvRequest The pvRequest.
+     * @return The request string.
+     */
+    static std::string requestToString(epics::pvData::PVStructurePtr const & pvRequest);
+    /**
+     * @brief Convert an introspection interface to the one line form used by a capture.
+     * @param field The introspection interface.
+     * @return The string.
+     */
+    static std::string fieldToString(epics::pvData::FieldConstPtr const & field);
+    /**
+     * @brief Convert the one line form used by a capture to an introspection interface.
+     * @param value The string created by fieldToString.
+     * @return The introspection interface. It is null if value is not valid.
+     */
+    static epics::pvData::FieldConstPtr stringToField(std::string const & value);
+private:
+    WorkloadRecorder();
+};
+
+}}
+
+#endif  /* WORKLOADRECORDER_H */
@@ -13,6 +13,7 @@
 
 #include <epicsGuard.h>
 #include <epicsThread.h>
+#include <epicsThreadPool.h>
 #include <pv/pvData.h>
 #include <pv/pvAccess.h>
 #include <pv/pvTimeStamp.h>
@@ -26,8 +27,12 @@
 
 #define epicsExportSharedSymbols
 #include "pv/pvStructureCopy.h"
+#include "pv/pvArrayPlugin.h"
 #include "pv/pvDatabase.h"
 #include "pv/channelProviderLocal.h"
+#include "pv/lockProfiler.h"
+#include "pv/traceLog.h"
+#include "pv/workloadRecorder.h"
 
 using namespace epics::pvData;
 using namespace epics::pvAccess;
@@ -97,22 +102,48 @@ private:
     {
         return shared_from_this();
     }
+    // how nProcess iterations are locked and notified
+    enum Batch {
+        // lock, beginGroupPut, process and endGroupPut for each iteration
+        batchNone,
+        // one lock, one group put, so monitors see one change
+        batchGroup,
+        // one lock, one group put for each iteration
+        batchLock
+    };
     ChannelProcessLocal(
         ChannelLocalPtr const &channelLocal,
         ChannelProcessRequester::shared_pointer const & channelProcessRequester,
+        PVStructurePtr const & pvRequest,
         PVRecordPtr const &pvRecord,
-        int nProcess)
+        int nProcess,
+        Batch batch,
+        bool async)
     :
       channelLocal(channelLocal),
       channelProcessRequester(channelProcessRequester),
+      pvRequest(pvRequest),
       pvRecord(pvRecord),
-      nProcess(nProcess)
+      nProcess(nProcess),
+      batch(batch),
+      async(async),
+      job(0)
     {
     }
+    static void asyncProcess(void *arg,epicsJobMode mode);
+    Status processRecord(PVRecordPtr const & pvr);
     ChannelLocalWPtr channelLocal;
     ChannelProcessRequester::weak_pointer channelProcessRequester;
+    PVStructurePtr pvRequest;
     PVRecordWPtr pvRecord;
     int nProcess;
+    Batch batch;
+    bool async;
+    epicsJob *job;
+    // keeps the pool of job alive
+    ChannelProviderLocalPtr provider;
+    // keeps this alive while job is queued or running
+    ChannelProcessLocalPtr self;
     Mutex mutex;
 };
 
@@ -125,6 +156,8 @@ ChannelProcessLocalPtr ChannelProcessLocal::create(
     PVFieldPtr pvField;
     PVStructurePtr pvOptions;
     int nProcess = 1;
+    Batch batch = batchNone;
+    bool async = false;
     if(pvRequest) pvField = pvRequest->getSubField("record._options");
     if(pvField) {
         pvOptions = static_pointer_cast<PVStructure>(pvField);
@@ -139,12 +172,36 @@ ChannelProcessLocalPtr ChannelProcessLocal::create(
                 nProcess = size;
             }
         }
+        PVStringPtr pvBatch = pvOptions->getSubField<PVString>("batch");
+        if(pvBatch) {
+            if(pvBatch->get()=="true") batch = batchGroup;
+            if(pvBatch->get()=="lock") batch = batchLock;
+        }
+        PVStringPtr pvAsync = pvOptions->getSubField<PVString>("async");
+        if(pvAsync && pvAsync->get()=="true") async = true;
     }
     ChannelProcessLocalPtr process(new ChannelProcessLocal(
         channelLocal,
         channelProcessRequester,
+        pvRequest,
         pvRecord,
-        nProcess));
+        nProcess,
+        batch,
+        async));
+    if(async) {
+        // one pool reference per provider, not per ChannelProcess
+        process->provider = std::tr1::static_pointer_cast<ChannelProviderLocal>(
+            channelLocal->getProvider());
+        epicsThreadPool *pool = process->provider ? process->provider->getThreadPool() : 0;
+        if(pool) process->job = epicsJobCreate(pool,&ChannelProcessLocal::asyncProcess,process.get());
+        if(!process->job) {
+            Status status(
+                Status::STATUSTYPE_ERROR,
+                "can not create async job");
+            channelProcessRequester->channelProcessConnect(status,ChannelProcessLocalPtr());
+            return ChannelProcessLocalPtr();
+        }
+    }
     if(pvRecord->getTraceLevel()>0)
     {
         cout << "ChannelProcessLocal::create";
@@ -157,6 +214,8 @@ ChannelProcessLocalPtr ChannelProcessLocal::create(
 ChannelProcessLocal::~ChannelProcessLocal()
 {
 //cout << "~ChannelProcessLocal()\n";
+    // the job is not queued, because a queued job holds self
+    if(job) epicsJobDestroy(job);
 }
 
 std::tr1::shared_ptr<Channel> ChannelProcessLocal::getChannel()
@@ -180,27 +239,83 @@ void ChannelProcessLocal::unlock()
 
 void ChannelProcessLocal::process()
 {
+    LockProfiler::Scope scope(LockProfiler::channelProcess);
     ChannelProcessRequester::shared_pointer requester = channelProcessRequester.lock();
     if(!requester) return;
     PVRecordPtr pvr(pvRecord.lock());
     if(!pvr) throw std::logic_error("pvRecord is deleted");
+    TraceLog::Span span(pvr->getTraceId(),TraceLog::channelProcess);
+    WorkloadRecorder::add(WorkloadRecorder::process,pvr->getRecordName(),pvRequest);
     if(pvr->getTraceLevel()>1)
     {
         cout << "ChannelProcessLocal::process";
         cout << " nProcess " << nProcess << endl;
     }
+    if(async) {
+        bool queued = false;
+        {
+            epicsGuard<Mutex> guard(mutex);
+            if(!self) {
+                self = getPtrSelf();
+                queued = (epicsJobQueue(job)==0);
+                if(!queued) self.reset();
+            }
+        }
+        if(queued) return;
+        Status status(Status::STATUSTYPE_ERROR,"process is already queued, running or can not be queued");
+        requester->processDone(status,getPtrSelf());
+        return;
+    }
+    requester->processDone(processRecord(pvr),getPtrSelf());
+}
+
+void ChannelProcessLocal::asyncProcess(void *arg,epicsJobMode mode)
+{
+    ChannelProcessLocal *channelProcess = static_cast<ChannelProcessLocal *>(arg);
+    ChannelProcessLocalPtr self;
+    {
+        epicsGuard<Mutex> guard(channelProcess->mutex);
+        self = channelProcess->self;
+    }
+    if(!self) return;
+    Status status;
+    PVRecordPtr pvr(self->pvRecord.lock());
+    if(mode!=epicsJobModeRun) {
+        // the pool is being destroyed
+        status = Status(Status::STATUSTYPE_ERROR,"thread pool stopped before process");
+    } else if(!pvr) {
+        status = Status(Status::STATUSTYPE_ERROR,"pvRecord is deleted");
+    } else {
+        status = self->processRecord(pvr);
+    }
+    {
+        // a requester can queue the next process from processDone
+        epicsGuard<Mutex> guard(channelProcess->mutex);
+        channelProcess->self.reset();
+    }
+    ChannelProcessRequester::shared_pointer requester = self->channelProcessRequester.lock();
+    if(requester) requester->processDone(status,self);
+}
+
+Status ChannelProcessLocal::processRecord(PVRecordPtr const & pvr)
+{
     try {
-        for(int i=0; i< nProcess; i++) {
+        if(batch==batchNone) {
+            for(int i=0; i< nProcess; i++) pvr->processGroupPut();
+        } else {
             epicsGuard <PVRecord> guard(*pvr);
-            pvr->beginGroupPut();
-            pvr->process();
-            pvr->endGroupPut();
+            if(batch==batchGroup) pvr->beginGroupPut();
+            for(int i=0; i< nProcess; i++) {
+                if(batch==batchLock) pvr->beginGroupPut();
+                pvr->process();
+                if(batch==batchLock) pvr->endGroupPut();
+            }
+            if(batch==batchGroup) pvr->endGroupPut();
         }
-        requester->processDone(Status::Ok,getPtrSelf());
     } catch(std::exception& ex) {
-        Status status = Status(Status::STATUSTYPE_FATAL, ex.what());
-        requester->processDone(status,getPtrSelf());
+        return Status(Status::STATUSTYPE_FATAL, ex.what());
     }
+    return Status::Ok;
 }
 
 class ChannelGetLocal :
@@ -234,6 +349,7 @@ private:
         PVCopyPtr const &pvCopy,
         PVStructurePtr const&pvStructure,
         BitSetPtr const & bitSet,
+        PVStructurePtr const & pvRequest,
         PVRecordPtr const &pvRecord)
     :
       firstTime(true),
@@ -243,6 +359,7 @@ private:
       pvCopy(pvCopy),
       pvStructure(pvStructure),
       bitSet(bitSet),
+      pvRequest(pvRequest),
       pvRecord(pvRecord)
     {
     }
@@ -253,6 +370,7 @@ private:
     PVCopyPtr pvCopy;
     PVStructurePtr pvStructure;
     BitSetPtr bitSet;
+    PVStructurePtr pvRequest;
     PVRecordWPtr pvRecord;
     Mutex mutex;
 };
@@ -263,8 +381,7 @@ ChannelGetLocalPtr ChannelGetLocal::create(
     PVStructurePtr const & pvRequest,
     PVRecordPtr const &pvRecord)
 {
-    PVCopyPtr pvCopy = PVCopy::create(
-        pvRecord->getPVRecordStructure()->getPVStructure(),
+    PVCopyPtr pvCopy = pvRecord->getPVCopy(
         pvRequest,
         "");
     if(!pvCopy) {
@@ -288,6 +405,7 @@ ChannelGetLocalPtr ChannelGetLocal::create(
         pvCopy,
         pvStructure,
         bitSet,
+        pvRequest,
         pvRecord));
     if(pvRecord->getTraceLevel()>0)
     {
@@ -326,16 +444,22 @@ void ChannelGetLocal::unlock()
 
 void ChannelGetLocal::get()
 {
+    LockProfiler::Scope scope(LockProfiler::channelGet);
     ChannelGetRequester::shared_pointer requester = channelGetRequester.lock();
     if(!requester) return;
     PVRecordPtr pvr(pvRecord.lock());
     if(!pvr) throw std::logic_error("pvRecord is deleted");
+    TraceLog::Span span(pvr->getTraceId(),TraceLog::channelGet);
+    WorkloadRecorder::add(WorkloadRecorder::get,pvr->getRecordName(),pvRequest);
     try {
         bool notifyClient = true;
         bitSet->clear();
+        // a coalesced process is done before the record is locked for the copy
+        bool coalesce = callProcess && pvr->getCoalesceProcess();
+        if(coalesce) pvr->processGroupPut();
         {
             epicsGuard <PVRecord> guard(*pvr);
-            if(callProcess) {
+            if(callProcess && !coalesce) {
                 pvr->beginGroupPut();
                 pvr->process();
                 pvr->endGroupPut();
@@ -404,12 +528,14 @@ private:
         ChannelLocalPtr const &channelLocal,
         ChannelPutRequester::shared_pointer const & channelPutRequester,
         PVCopyPtr const &pvCopy,
+        PVStructurePtr const & pvRequest,
         PVRecordPtr const &pvRecord)
     :
       callProcess(callProcess),
       channelLocal(channelLocal),
       channelPutRequester(channelPutRequester),
       pvCopy(pvCopy),
+      pvRequest(pvRequest),
       pvRecord(pvRecord)
     {
     }
@@ -417,6 +543,7 @@ private:
     ChannelLocalWPtr channelLocal;
     ChannelPutRequester::weak_pointer channelPutRequester;
     PVCopyPtr pvCopy;
+    PVStructurePtr pvRequest;
     PVRecordWPtr pvRecord;
     Mutex mutex;
 };
@@ -427,8 +554,7 @@ ChannelPutLocalPtr ChannelPutLocal::create(
     PVStructurePtr const & pvRequest,
     PVRecordPtr const &pvRecord)
 {
-    PVCopyPtr pvCopy = PVCopy::create(
-        pvRecord->getPVRecordStructure()->getPVStructure(),
+    PVCopyPtr pvCopy = pvRecord->getPVCopy(
         pvRequest,
         "");
     if(!pvCopy) {
@@ -450,6 +576,7 @@ ChannelPutLocalPtr ChannelPutLocal::create(
         channelLocal,
         channelPutRequester,
         pvCopy,
+        pvRequest,
         pvRecord));
     channelPutRequester->channelPutConnect(
         Status::Ok, put, pvCopy->getStructure());
@@ -488,10 +615,12 @@ void ChannelPutLocal::unlock()
 
 void ChannelPutLocal::get()
 {
+    LockProfiler::Scope scope(LockProfiler::channelPut);
     ChannelPutRequester::shared_pointer requester = channelPutRequester.lock();
     if(!requester) return;
     PVRecordPtr pvr(pvRecord.lock());
     if(!pvr) throw std::logic_error("pvRecord is deleted");
+    TraceLog::Span span(pvr->getTraceId(),TraceLog::channelPut);
     try {
         PVStructurePtr pvStructure = pvCopy->createPVStructure();
          BitSetPtr bitSet(new BitSet(pvStructure->getNumberFields()));
@@ -518,20 +647,28 @@ void ChannelPutLocal::get()
 void ChannelPutLocal::put(
     PVStructurePtr const &pvStructure,BitSetPtr const &bitSet)
 {
+    LockProfiler::Scope scope(LockProfiler::channelPut);
     ChannelPutRequester::shared_pointer requester = channelPutRequester.lock();
     if(!requester) return;
     PVRecordPtr pvr(pvRecord.lock());
     if(!pvr) throw std::logic_error("pvRecord is deleted");
+    TraceLog::Span span(pvr->getTraceId(),TraceLog::channelPut);
+    WorkloadRecorder::add(
+        WorkloadRecorder::put,pvr->getRecordName(),pvRequest,pvStructure,bitSet);
     try {
+        // a coalesced process is a separate group put after the put,
+        // so monitors see the put and the process as two updates
+        bool coalesce = callProcess && pvr->getCoalesceProcess();
         {
             epicsGuard <PVRecord> guard(*pvr);
             pvr->beginGroupPut();
             pvCopy->updateMaster(pvStructure, bitSet);
-            if(callProcess) {
+            if(callProcess && !coalesce) {
                  pvr->process();
             }
             pvr->endGroupPut();
         }
+        if(coalesce) pvr->processGroupPut();
         requester->putDone(Status::Ok,getPtrSelf());
         if(pvr->getTraceLevel()>1)
         {
@@ -578,6 +715,8 @@ private:
         ChannelPutGetRequester::weak_pointer const & channelPutGetRequester,
         PVCopyPtr const &pvPutCopy,
         PVCopyPtr const &pvGetCopy,
+        PVStructurePtr const&pvPutStructure,
+        BitSetPtr const & putBitSet,
         PVStructurePtr const&pvGetStructure,
         BitSetPtr const & getBitSet,
         PVRecordPtr const &pvRecord)
@@ -587,6 +726,8 @@ private:
       channelPutGetRequester(channelPutGetRequester),
       pvPutCopy(pvPutCopy),
       pvGetCopy(pvGetCopy),
+      pvPutStructure(pvPutStructure),
+      putBitSet(putBitSet),
       pvGetStructure(pvGetStructure),
       getBitSet(getBitSet),
       pvRecord(pvRecord)
@@ -597,6 +738,9 @@ private:
     ChannelPutGetRequester::weak_pointer channelPutGetRequester;
     PVCopyPtr pvPutCopy;
     PVCopyPtr pvGetCopy;
+    // used by getPut, which like getGet reuses one structure
+    PVStructurePtr pvPutStructure;
+    BitSetPtr putBitSet;
     PVStructurePtr pvGetStructure;
     BitSetPtr getBitSet;
     PVRecordWPtr pvRecord;
@@ -609,12 +753,10 @@ ChannelPutGetLocalPtr ChannelPutGetLocal::create(
     PVStructurePtr const & pvRequest,
     PVRecordPtr const &pvRecord)
 {
-    PVCopyPtr pvPutCopy = PVCopy::create(
-        pvRecord->getPVRecordStructure()->getPVStructure(),
+    PVCopyPtr pvPutCopy = pvRecord->getPVCopy(
         pvRequest,
         "putField");
-    PVCopyPtr pvGetCopy = PVCopy::create(
-        pvRecord->getPVRecordStructure()->getPVStructure(),
+    PVCopyPtr pvGetCopy = pvRecord->getPVCopy(
         pvRequest,
         "getField");
     if(!pvPutCopy || !pvGetCopy) {
@@ -630,6 +772,8 @@ ChannelPutGetLocalPtr ChannelPutGetLocal::create(
         ChannelPutGetLocalPtr localPutGet;
         return localPutGet;
     }
+    PVStructurePtr pvPutStructure = pvPutCopy->createPVStructure();
+    BitSetPtr   putBitSet(new BitSet(pvPutStructure->getNumberFields()));
     PVStructurePtr pvGetStructure = pvGetCopy->createPVStructure();
     BitSetPtr   getBitSet(new BitSet(pvGetStructure->getNumberFields()));
     ChannelPutGetLocalPtr putGet(new ChannelPutGetLocal(
@@ -638,6 +782,8 @@ ChannelPutGetLocalPtr ChannelPutGetLocal::create(
         channelPutGetRequester,
         pvPutCopy,
         pvGetCopy,
+        pvPutStructure,
+        putBitSet,
         pvGetStructure,
         getBitSet,
         pvRecord));
@@ -679,10 +825,12 @@ void ChannelPutGetLocal::unlock()
 void ChannelPutGetLocal::putGet(
     PVStructurePtr const &pvPutStructure,BitSetPtr const &putBitSet)
 {
+    LockProfiler::Scope scope(LockProfiler::channelPutGet);
     ChannelPutGetRequester::shared_pointer requester = channelPutGetRequester.lock();
     if(!requester) return;
     PVRecordPtr pvr(pvRecord.lock());
     if(!pvr) throw std::logic_error("pvRecord is deleted");
+    TraceLog::Span span(pvr->getTraceId(),TraceLog::channelPutGet);
     try {
         {
             epicsGuard <PVRecord> guard(*pvr);
@@ -707,13 +855,13 @@ void ChannelPutGetLocal::putGet(
 
 void ChannelPutGetLocal::getPut()
 {
+    LockProfiler::Scope scope(LockProfiler::channelPutGet);
     ChannelPutGetRequester::shared_pointer requester = channelPutGetRequester.lock();
     if(!requester) return;
     PVRecordPtr pvr(pvRecord.lock());
     if(!pvr) throw std::logic_error("pvRecord is deleted");
+    TraceLog::Span span(pvr->getTraceId(),TraceLog::channelPutGet);
     try {
-        PVStructurePtr pvPutStructure = pvPutCopy->createPVStructure();
-        BitSetPtr putBitSet(new BitSet(pvPutStructure->getNumberFields()));
         {
             epicsGuard <PVRecord> guard(*pvr);
             pvPutCopy->initCopy(pvPutStructure, putBitSet);
@@ -726,18 +874,18 @@ void ChannelPutGetLocal::getPut()
         }
     } catch(std::exception& ex) {
         Status status = Status(Status::STATUSTYPE_FATAL, ex.what());
-        PVStructurePtr pvPutStructure;
-        BitSetPtr putBitSet;
-        requester->getPutDone(status,getPtrSelf(),pvGetStructure,getBitSet);
+        requester->getPutDone(status,getPtrSelf(),pvPutStructure,putBitSet);
     }
 }
 
 void ChannelPutGetLocal::getGet()
 {
+    LockProfiler::Scope scope(LockProfiler::channelPutGet);
     ChannelPutGetRequester::shared_pointer requester = channelPutGetRequester.lock();
     if(!requester) return;
     PVRecordPtr pvr(pvRecord.lock());
     if(!pvr) throw std::logic_error("pvRecord is deleted");
+    TraceLog::Span span(pvr->getTraceId(),TraceLog::channelPutGet);
     try {
          getBitSet->clear();
          {
@@ -752,8 +900,6 @@ void ChannelPutGetLocal::getGet()
          }
     } catch(std::exception& ex) {
         Status status = Status(Status::STATUSTYPE_FATAL, ex.what());
-        PVStructurePtr pvPutStructure;
-        BitSetPtr putBitSet;
         requester->getGetDone(status,getPtrSelf(),pvGetStructure,getBitSet);
     }
 }
@@ -1113,10 +1259,12 @@ void ChannelArrayLocal::unlock()
 
 void ChannelArrayLocal::getArray(size_t offset, size_t count, size_t stride)
 {
+    LockProfiler::Scope scope(LockProfiler::channelArray);
     ChannelArrayRequester::shared_pointer requester = channelArrayRequester.lock();
     if(!requester) return;
     PVRecordPtr pvr(pvRecord.lock());
     if(!pvr) throw std::logic_error("pvRecord is deleted");
+    TraceLog::Span span(pvr->getTraceId(),TraceLog::channelArray);
     if(pvr->getTraceLevel()>1)
     {
        cout << "ChannelArrayLocal::getArray" << endl;
@@ -1139,8 +1287,19 @@ void ChannelArrayLocal::getArray(size_t offset, size_t count, size_t stride)
             break;
         }
         if(ok) {
-            pvCopy->setLength(count);
-            copy(pvArray,offset,stride,pvCopy,0,1,count);
+            bool shared = false;
+            if(stride==1 && pvArray->getField()->getType()==scalarArray) {
+                // the client gets a slice of the frozen master buffer
+                shared = PVArrayFilter::shareSubArray(
+                    static_cast<PVScalarArray &>(*pvCopy),
+                    static_cast<PVScalarArray const &>(*pvArray),
+                    offset,
+                    count);
+            }
+            if(!shared) {
+                pvCopy->setLength(count);
+                copy(pvArray,offset,stride,pvCopy,0,1,count);
+            }
         }
     } catch(std::exception& e) {
         exceptionMessage = e.what();
@@ -1155,10 +1314,12 @@ void ChannelArrayLocal::getArray(size_t offset, size_t count, size_t stride)
 void ChannelArrayLocal::putArray(
      PVArrayPtr const & pvArray, size_t offset, size_t count, size_t stride)
 {
+    LockProfiler::Scope scope(LockProfiler::channelArray);
     ChannelArrayRequester::shared_pointer requester = channelArrayRequester.lock();
     if(!requester) return;
     PVRecordPtr pvr(pvRecord.lock());
     if(!pvr) throw std::logic_error("pvRecord is deleted");
+    TraceLog::Span span(pvr->getTraceId(),TraceLog::channelArray);
     if(pvr->getTraceLevel()>1)
     {
        cout << "ChannelArrayLocal::putArray" << endl;
@@ -1181,10 +1342,12 @@ void ChannelArrayLocal::putArray(
 
 void ChannelArrayLocal::getLength()
 {
+    LockProfiler::Scope scope(LockProfiler::channelArray);
     ChannelArrayRequester::shared_pointer requester = channelArrayRequester.lock();
     if(!requester) return;
     PVRecordPtr pvr(pvRecord.lock());
     if(!pvr) throw std::logic_error("pvRecord is deleted");
+    TraceLog::Span span(pvr->getTraceId(),TraceLog::channelArray);
     size_t length = 0;
     const char *exceptionMessage = NULL;
     try {
@@ -1202,10 +1365,12 @@ void ChannelArrayLocal::getLength()
 
 void ChannelArrayLocal::setLength(size_t length)
 {
+    LockProfiler::Scope scope(LockProfiler::channelArray);
     ChannelArrayRequester::shared_pointer requester = channelArrayRequester.lock();
     if(!requester) return;
     PVRecordPtr pvr(pvRecord.lock());
     if(!pvr) throw std::logic_error("pvRecord is deleted");
+    TraceLog::Span span(pvr->getTraceId(),TraceLog::channelArray);
     if(pvr->getTraceLevel()>1)
     {
        cout << "ChannelArrayLocal::setLength" << endl;
@@ -1231,7 +1396,8 @@ ChannelLocal::ChannelLocal(
 :
     requester(requester),
     provider(provider),
-    pvRecord(pvRecord)
+    pvRecord(pvRecord),
+    clientHandle(PVRecord::noClientHandle)
 {
     if(pvRecord->getTraceLevel()>0) {
          cout << "ChannelLocal::ChannelLocal()"
@@ -1244,6 +1410,8 @@ ChannelLocal::ChannelLocal(
 ChannelLocal::~ChannelLocal()
 {
 // cout << "~ChannelLocal()" << endl;
+    PVRecordPtr pvr(pvRecord.lock());
+    if(pvr) pvr->removePVRecordClient(clientHandle,this);
 }
 
 ChannelProvider::shared_pointer ChannelLocal::getProvider()
@@ -1477,7 +1645,7 @@ Monitor::shared_pointer ChannelLocal::createMonitor(
          << " requester exists " << (requester ? "true" : "false")
          << endl;
     }
-
+    WorkloadRecorder::add(WorkloadRecorder::monitor,pvr->getRecordName(),pvRequest);
     MonitorPtr monitor = createMonitorLocal(
             pvr,
             monitorRequester,
@@ -10,6 +10,8 @@
  */
 
 #include <epicsThread.h>
+#include <epicsThreadPool.h>
+#include <epicsGuard.h>
 #include <pv/serverContext.h>
 #include <pv/syncChannelFind.h>
 #include <pv/pvTimeStamp.h>
@@ -20,6 +22,7 @@
 #include "pv/pvStructureCopy.h"
 #include "pv/pvDatabase.h"
 #include "pv/channelProviderLocal.h"
+#include "pv/workloadRecorder.h"
 
 using namespace epics::pvData;
 using namespace epics::pvAccess;
@@ -69,7 +72,8 @@ ChannelProviderLocalPtr getChannelProviderLocal()
 
 ChannelProviderLocal::ChannelProviderLocal()
 : pvDatabase(PVDatabase::getMaster()),
-  traceLevel(0)
+  traceLevel(0),
+  threadPool(0)
 {
     if(traceLevel>0) {
         cout << "ChannelProviderLocal::ChannelProviderLocal()\n";
@@ -81,6 +85,18 @@ ChannelProviderLocal::~ChannelProviderLocal()
     if(traceLevel>0) {
         cout << "ChannelProviderLocal::~ChannelProviderLocal()\n";
     }
+    if(threadPool) epicsThreadPoolReleaseShared(threadPool);
+}
+
+epicsThreadPool * ChannelProviderLocal::getThreadPool()
+{
+    epicsGuard<epics::pvData::Mutex> guard(mutex);
+    if(!threadPool) {
+        epicsThreadPoolConfig config;
+        epicsThreadPoolConfigDefaults(&config);
+        threadPool = epicsThreadPoolGetShared(&config);
+    }
+    return threadPool;
 }
 
 std::tr1::shared_ptr<ChannelProvider> ChannelProviderLocal::getChannelProvider()
@@ -107,6 +123,7 @@ ChannelFind::shared_pointer ChannelProviderLocal::channelFind(
             notFoundStatus,
             shared_from_this(),
             false);
+        return shared_from_this();
     }
     PVRecordPtr pvRecord = pvdb->findRecord(channelName);
     if(pvRecord) {
@@ -133,7 +150,8 @@ ChannelFind::shared_pointer ChannelProviderLocal::channelList(
     }
     PVDatabasePtr pvdb(pvDatabase.lock());
     if(!pvdb)throw std::logic_error("pvDatabase was deleted");
-    PVStringArrayPtr records(pvdb->getRecordNames());
+    // an alias is also a channel name
+    PVStringArrayPtr records(pvdb->getRecordNames(true));
     channelListRequester->channelListResult(
         Status::Ok, shared_from_this(), records->view(), false);
     return shared_from_this();
@@ -157,7 +175,12 @@ Channel::shared_pointer ChannelProviderLocal::createChannel(
         if(pvRecord) {
             channel = ChannelLocalPtr(new ChannelLocal(
                 shared_from_this(),channelRequester,pvRecord));
-            pvRecord->addPVRecordClient(channel);
+            if(!pvRecord->addPVRecordClient(channel,channel->clientHandle)) {
+                channel.reset();
+                status = Status::error("pv not found");
+            } else {
+                WorkloadRecorder::addCreateChannel(*pvRecord);
+            }
        } else {
             status = Status::error("pv not found");
        }
@@ -176,4 +199,46 @@ Channel::shared_pointer ChannelProviderLocal::createChannel(
     return createChannel(channelName, channelRequester, priority);
 }
 
+size_t ChannelProviderLocal::createChannels(
+    std::vector<string> const & channelNames,
+    ChannelRequester::shared_pointer  const &channelRequester,
+    short priority,
+    std::vector<Channel::shared_pointer> & channels)
+{
+    if(traceLevel>1) {
+        cout << "ChannelProviderLocal::createChannels " << channelNames.size() << endl;
+    }
+    size_t number = channelNames.size();
+    channels.assign(number,Channel::shared_pointer());
+    PVDatabasePtr pvdb(pvDatabase.lock());
+    std::vector<PVRecordPtr> records;
+    if(pvdb) pvdb->findRecords(channelNames,records);
+    size_t created = 0;
+    for(size_t i=0; i<number; ++i) {
+        ChannelLocalPtr channel;
+        Status status = Status::Ok;
+        PVRecordPtr pvRecord;
+        if(!pvdb) {
+            status = Status::error("pvDatabase was deleted");
+        } else {
+            pvRecord = records[i];
+            if(!pvRecord) status = Status::error("pv not found");
+        }
+        if(pvRecord) {
+            channel = ChannelLocalPtr(new ChannelLocal(
+                shared_from_this(),channelRequester,pvRecord));
+            if(!pvRecord->addPVRecordClient(channel,channel->clientHandle)) {
+                channel.reset();
+                status = Status::error("pv not found");
+            } else {
+                WorkloadRecorder::addCreateChannel(*pvRecord);
+                ++created;
+            }
+        }
+        channelRequester->channelCreated(status,channel);
+        channels[i] = channel;
+    }
+    return created;
+}
+
 }}
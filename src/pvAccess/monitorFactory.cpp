@@ -25,6 +25,8 @@
 #include "pv/pvStructureCopy.h"
 #include "pv/pvDatabase.h"
 #include "pv/channelProviderLocal.h"
+#include "pv/lockProfiler.h"
+#include "pv/traceLog.h"
 
 using namespace epics::pvData;
 using namespace epics::pvAccess;
@@ -151,6 +153,10 @@ public:
     virtual void dataPut(
         PVRecordStructurePtr const & requested,
         PVRecordFieldPtr const & pvRecordField);
+    virtual bool isBitSetListener() { return true;}
+    virtual void dataPut(
+        PVRecordPtr const & pvRecord,
+        BitSet const & changed);
     virtual void beginGroupPut(PVRecordPtr const & pvRecord);
     virtual void endGroupPut(PVRecordPtr const & pvRecord);
     virtual void unlisten(PVRecordPtr const & pvRecord);
@@ -174,6 +180,9 @@ private:
     MonitorElementPtr activeElement;
     bool isGroupPut;
     bool dataChanged;
+    // scratch space for dataPut(pvRecord,changed)
+    BitSet copyChanged;
+    BitSet copyOverrun;
     Mutex mutex;
     Mutex queueMutex;
 };
@@ -197,6 +206,7 @@ MonitorLocal::~MonitorLocal()
 
 Status MonitorLocal::start()
 {
+    LockProfiler::Scope scope(LockProfiler::monitorStart);
     if(pvRecord->getTraceLevel()>0)
     {
         cout << "MonitorLocal::start state " << state << endl;
@@ -206,7 +216,7 @@ Status MonitorLocal::start()
         if(state==active) return alreadyStartedStatus;
         if(state==deleted) return deletedStatus;
     }
-    pvRecord->addListener(getPtrSelf(),pvCopy);
+    if(!pvRecord->addListener(getPtrSelf(),pvCopy)) return deletedStatus;
     epicsGuard <PVRecord> guard(*pvRecord);
     Lock xx(mutex);
     state = active;
@@ -267,6 +277,7 @@ void MonitorLocal::releaseActiveElement()
     {
         cout << "MonitorLocal::releaseActiveElement  state  " << state << endl;
     }
+    TraceLog::Span span(pvRecord->getTraceId(),TraceLog::monitorEvent);
     {
         Lock xx(queueMutex);
         if(state!=active) return;
@@ -339,6 +350,34 @@ void MonitorLocal::dataPut(
     }
 }
 
+void MonitorLocal::dataPut(
+        PVRecordPtr const & pvRecord,
+        BitSet const & changed)
+{
+    if(pvRecord->getTraceLevel()>1)
+    {
+        cout << "MonitorLocal::dataPut(pvRecord,changed)" << endl;
+    }
+    if(state!=active) return;
+    {
+        Lock xx(mutex);
+        copyChanged.clear();
+        pvCopy->mapMasterBitSet(changed,copyChanged);
+        if(copyChanged.nextSetBit(0)<0) return;
+        BitSetPtr const &changedBitSet = activeElement->changedBitSet;
+        BitSetPtr const &overrunBitSet = activeElement->overrunBitSet;
+        copyOverrun = copyChanged;
+        copyOverrun &= *changedBitSet;
+        *overrunBitSet |= copyOverrun;
+        *changedBitSet |= copyChanged;
+        dataChanged = true;
+    }
+    if(!isGroupPut) {
+        releaseActiveElement();
+        dataChanged = false;
+    }
+}
+
 void MonitorLocal::beginGroupPut(PVRecordPtr const & pvRecord)
 {
     if(pvRecord->getTraceLevel()>1)
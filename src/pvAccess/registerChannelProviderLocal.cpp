@@ -42,6 +42,27 @@ extern "C" void pvdbl(const iocshArgBuf *args)
     for(size_t i=0; i<xxx.size(); ++i) cout<< xxx[i] << endl;
 }
 
+static const iocshArg pvdbAliasArg0 = { "recordName", iocshArgString };
+static const iocshArg pvdbAliasArg1 = { "aliasName", iocshArgString };
+static const iocshArg *pvdbAliasArgs[] = {
+    &pvdbAliasArg0,&pvdbAliasArg1};
+
+static const iocshFuncDef pvdbAliasFuncDef = {
+    "pvdbAlias", 2, pvdbAliasArgs
+};
+extern "C" void pvdbAlias(const iocshArgBuf *args)
+{
+    char *recordName = args[0].sval;
+    char *aliasName = args[1].sval;
+    if(!recordName || !aliasName) {
+        cout << "pvdbAlias recordName aliasName" << endl;
+        return;
+    }
+    PVDatabasePtr master = PVDatabase::getMaster();
+    if(!master->addAlias(aliasName,recordName)) {
+        cout << "pvdbAlias could not add " << aliasName << " for " << recordName << endl;
+    }
+}
 
 static void registerChannelProviderLocal(void)
 {
@@ -50,6 +71,7 @@ cout << "registerChannelProviderLocal firstTime " << (firstTime ? "true" : "fals
     if (firstTime) {
         firstTime = 0;
         iocshRegister(&pvdblFuncDef, pvdbl);
+        iocshRegister(&pvdbAliasFuncDef, pvdbAlias);
         getChannelProviderLocal();
     }
 }
@@ -0,0 +1,431 @@
+/* workloadRecorder.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+
+#include <set>
+#include <map>
+#include <stdexcept>
+#include <sstream>
+#include <fstream>
+#include <cstdlib>
+#include <epicsGuard.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsAtomic.h>
+#include <pv/lock.h>
+#include <pv/json.h>
+
+#define epicsExportSharedSymbols
+#include "pv/pvDatabase.h"
+#include "pv/workloadRecorder.h"
+
+using namespace epics::pvData;
+using std::string;
+using std::vector;
+
+namespace epics { namespace pvDatabase {
+
+namespace {
+
+const char * operationNames[WorkloadRecorder::numberOperations] = {
+    "record",
+    "createChannel",
+    "get",
+    "put",
+    "process",
+    "monitor"
+};
+
+epicsThreadOnceId recorderOnce = EPICS_THREAD_ONCE_INIT;
+epics::pvData::Mutex *recorderMutex;
+std::set<string> *recorded;
+std::map<epicsThreadId,size_t> *clients;
+std::ofstream *out;
+uint64 startTime = 0;
+int active = 0;
+
+void createRecorder(void *)
+{
+    recorderMutex = new epics::pvData::Mutex();
+    recorded = new std::set<string>();
+    clients = new std::map<epicsThreadId,size_t>();
+}
+
+void initRecorder()
+{
+    epicsThreadOnce(&recorderOnce,createRecorder,0);
+}
+
+// caller holds recorderMutex
+void writeLine(
+    WorkloadRecorder::Operation operation,
+    string const & channelName,
+    string const & request,
+    string const & value)
+{
+    if(!out) return;
+    uint64 elapsed = (epicsMonotonicGet() - startTime)/1000;
+    size_t & client = (*clients)[epicsThreadGetIdSelf()];
+    if(client==0) client = clients->size();
+    *out << elapsed << '\t' << client << '\t' << operationNames[operation] << '\t'
+         << channelName << '\t' << request << '\t' << value << '\n';
+}
+
+void appendOptions(string & result,PVStructurePtr const & pvOptions)
+{
+    if(!pvOptions) return;
+    PVFieldPtrArray const & pvFields = pvOptions->getPVFields();
+    if(pvFields.empty()) return;
+    result += '[';
+    for(size_t i=0; i<pvFields.size(); ++i) {
+        PVScalarPtr pvScalar = std::tr1::dynamic_pointer_cast<PVScalar>(pvFields[i]);
+        if(!pvScalar) continue;
+        if(result[result.size()-1]!='[') result += ',';
+        result += pvFields[i]->getFieldName() + '=' + pvScalar->getAs<string>();
+    }
+    result += ']';
+}
+
+// Appends the leaves of a field selection as dotted names.
+void appendFields(string & result,PVStructurePtr const & pvStructure,string const & prefix)
+{
+    PVFieldPtrArray const & pvFields = pvStructure->getPVFields();
+    for(size_t i=0; i<pvFields.size(); ++i) {
+        string name = pvFields[i]->getFieldName();
+        if(name=="_options") continue;
+        PVStructurePtr pvNode = std::tr1::dynamic_pointer_cast<PVStructure>(pvFields[i]);
+        if(!pvNode) continue;
+        string fullName = prefix.empty() ? name : prefix + '.' + name;
+        size_t numberSubfields = pvNode->getPVFields().size();
+        if(pvNode->getSubField("_options")) --numberSubfields;
+        if(numberSubfields>0) {
+            appendFields(result,pvNode,fullName);
+            continue;
+        }
+        if(!result.empty() && result[result.size()-1]!='(') result += ',';
+        result += fullName;
+        appendOptions(result,pvNode->getSubField<PVStructure>("_options"));
+    }
+}
+
+void appendField(string & result,FieldConstPtr const & field);
+
+void appendMembers(string & result,StringArray const & names,FieldConstPtrArray const & fields)
+{
+    result += '{';
+    for(size_t i=0; i<fields.size(); ++i) {
+        if(i>0) result += ',';
+        result += names[i] + ' ';
+        appendField(result,fields[i]);
+    }
+    result += '}';
+}
+
+void appendField(string & result,FieldConstPtr const & field)
+{
+    switch(field->getType()) {
+    case scalar:
+        result += ScalarTypeFunc::name(
+            std::tr1::static_pointer_cast<const Scalar>(field)->getScalarType());
+        return;
+    case scalarArray:
+        result += ScalarTypeFunc::name(
+            std::tr1::static_pointer_cast<const ScalarArray>(field)->getElementType());
+        result += "[]";
+        return;
+    case structure:
+    case structureArray:
+    {
+        StructureConstPtr structure = (field->getType()==structure)
+            ? std::tr1::static_pointer_cast<const Structure>(field)
+            : std::tr1::static_pointer_cast<const StructureArray>(field)->getStructure();
+        result += "structure(" + structure->getID() + ")";
+        if(field->getType()==structureArray) result += "[]";
+        appendMembers(result,structure->getFieldNames(),structure->getFields());
+        return;
+    }
+    case union_:
+    case unionArray:
+    {
+        UnionConstPtr u = (field->getType()==union_)
+            ? std::tr1::static_pointer_cast<const Union>(field)
+            : std::tr1::static_pointer_cast<const UnionArray>(field)->getUnion();
+        if(u->isVariant()) {
+            result += "any";
+            if(field->getType()==unionArray) result += "[]";
+            return;
+        }
+        result += "union(" + u->getID() + ")";
+        if(field->getType()==unionArray) result += "[]";
+        appendMembers(result,u->getFieldNames(),u->getFields());
+        return;
+    }
+    }
+}
+
+class FieldParser {
+public:
+    explicit FieldParser(string const & value) : value(value), pos(0) {}
+    FieldConstPtr parse()
+    {
+        FieldConstPtr field = parseField();
+        if(pos!=value.size()) return FieldConstPtr();
+        return field;
+    }
+private:
+    bool expect(char c)
+    {
+        if(pos>=value.size() || value[pos]!=c) return false;
+        ++pos;
+        return true;
+    }
+    string token(const char * stop)
+    {
+        size_t end = value.find_first_of(stop,pos);
+        if(end==string::npos) end = value.size();
+        string result = value.substr(pos,end-pos);
+        pos = end;
+        return result;
+    }
+    bool parseMembers(StringArray & names,FieldConstPtrArray & fields)
+    {
+        if(!expect('{')) return false;
+        if(expect('}')) return true;
+        while(true) {
+            string name = token(" ");
+            if(name.empty() || !expect(' ')) return false;
+            FieldConstPtr field = parseField();
+            if(!field) return false;
+            names.push_back(name);
+            fields.push_back(field);
+            if(expect('}')) return true;
+            if(!expect(',')) return false;
+        }
+    }
+    FieldConstPtr parseField()
+    {
+        FieldCreatePtr fieldCreate = getFieldCreate();
+        string kind = token("([,}");
+        if(kind=="any") {
+            if(expect('[')) {
+                if(!expect(']')) return FieldConstPtr();
+                return fieldCreate->createVariantUnionArray();
+            }
+            return fieldCreate->createVariantUnion();
+        }
+        if(kind=="structure" || kind=="union") {
+            if(!expect('(')) return FieldConstPtr();
+            string id = token(")");
+            if(!expect(')')) return FieldConstPtr();
+            bool isArray = false;
+            if(expect('[')) {
+                if(!expect(']')) return FieldConstPtr();
+                isArray = true;
+            }
+            StringArray names;
+            FieldConstPtrArray fields;
+            if(!parseMembers(names,fields)) return FieldConstPtr();
+            if(kind=="structure") {
+                StructureConstPtr structure = fieldCreate->createStructure(id,names,fields);
+                if(isArray) return fieldCreate->createStructureArray(structure);
+                return structure;
+            }
+            UnionConstPtr u = fieldCreate->createUnion(id,names,fields);
+            if(isArray) return fieldCreate->createUnionArray(u);
+            return u;
+        }
+        ScalarType scalarType;
+        try {
+            scalarType = ScalarTypeFunc::getScalarType(kind);
+        } catch(std::exception &) {
+            return FieldConstPtr();
+        }
+        if(expect('[')) {
+            if(!expect(']')) return FieldConstPtr();
+            return fieldCreate->createScalarArray(scalarType);
+        }
+        return fieldCreate->createScalar(scalarType);
+    }
+    string const & value;
+    size_t pos;
+};
+
+string printValue(PVStructure const & pvStructure,BitSet const * bitSet)
+{
+    JSONPrintOptions options;
+    options.multiLine = false;
+    std::ostringstream ss;
+    if(bitSet) {
+        printJSON(ss,pvStructure,*bitSet,options);
+    } else {
+        printJSON(ss,pvStructure,options);
+    }
+    return ss.str();
+}
+
+}
+
+bool WorkloadRecorder::start(string const & fileName)
+{
+    initRecorder();
+    epicsGuard<epics::pvData::Mutex> guard(*recorderMutex);
+    if(out) return false;
+    std::ofstream *file = new std::ofstream(fileName.c_str());
+    if(!*file) {
+        delete file;
+        return false;
+    }
+    out = file;
+    recorded->clear();
+    clients->clear();
+    startTime = epicsMonotonicGet();
+    epicsAtomicSetIntT(&active,1);
+    return true;
+}
+
+void WorkloadRecorder::stop()
+{
+    initRecorder();
+    epicsGuard<epics::pvData::Mutex> guard(*recorderMutex);
+    epicsAtomicSetIntT(&active,0);
+    delete out;
+    out = 0;
+}
+
+bool WorkloadRecorder::isActive()
+{
+    return epicsAtomicGetIntT(&active)!=0;
+}
+
+void WorkloadRecorder::addCreateChannel(PVRecord & pvRecord)
+{
+    if(!isActive()) return;
+    string const & recordName = pvRecord.getRecordName();
+    bool known;
+    {
+        epicsGuard<epics::pvData::Mutex> guard(*recorderMutex);
+        known = recorded->find(recordName)!=recorded->end();
+    }
+    string type;
+    string value;
+    if(!known) {
+        // recorderMutex is never held while taking a record lock
+        epicsGuard<PVRecord> guard(pvRecord);
+        PVStructurePtr pvStructure = pvRecord.getPVStructure();
+        type = fieldToString(pvStructure->getStructure());
+        value = printValue(*pvStructure,0);
+    }
+    epicsGuard<epics::pvData::Mutex> guard(*recorderMutex);
+    if(!known && recorded->insert(recordName).second) {
+        writeLine(record,recordName,type,value);
+    }
+    writeLine(createChannel,recordName,"","");
+}
+
+void WorkloadRecorder::add(
+    Operation operation,
+    string const & channelName,
+    PVStructurePtr const & pvRequest,
+    PVStructurePtr const & pvPut,
+    BitSetPtr const & putBitSet)
+{
+    if(!isActive()) return;
+    string request = requestToString(pvRequest);
+    string value;
+    if(pvPut) value = printValue(*pvPut,putBitSet.get());
+    epicsGuard<epics::pvData::Mutex> guard(*recorderMutex);
+    writeLine(operation,channelName,request,value);
+}
+
+bool WorkloadRecorder::read(std::istream & in,Event & event,size_t & lineNumber)
+{
+    string line;
+    while(std::getline(in,line)) {
+        ++lineNumber;
+        if(line.empty()) continue;
+        std::ostringstream error;
+        error << "line " << lineNumber << ": ";
+        vector<string> items;
+        size_t start = 0;
+        while(items.size()<5) {
+            size_t end = line.find('\t',start);
+            if(end==string::npos) {
+                error << "expected 6 tab separated fields";
+                throw std::runtime_error(error.str());
+            }
+            items.push_back(line.substr(start,end-start));
+            start = end + 1;
+        }
+        event.value = line.substr(start);
+        char * end = 0;
+        event.time = strtod(items[0].c_str(),&end)*1e-6;
+        if(items[0].empty() || *end!='\0') {
+            error << "bad time \"" << items[0] << "\"";
+            throw std::runtime_error(error.str());
+        }
+        event.client = strtoul(items[1].c_str(),&end,10);
+        if(items[1].empty() || *end!='\0') {
+            error << "bad client \"" << items[1] << "\"";
+            throw std::runtime_error(error.str());
+        }
+        int operation = 0;
+        while(operation<numberOperations && items[2]!=operationNames[operation]) ++operation;
+        if(operation==numberOperations) {
+            error << "unknown operation \"" << items[2] << "\"";
+            throw std::runtime_error(error.str());
+        }
+        event.operation = static_cast<Operation>(operation);
+        event.channelName = items[3];
+        event.request = items[4];
+        return true;
+    }
+    return false;
+}
+
+const char * WorkloadRecorder::getOperationName(Operation operation)
+{
+    if(operation<0 || operation>=numberOperations) return "unknown";
+    return operationNames[operation];
+}
+
+string WorkloadRecorder::requestToString(PVStructurePtr const & pvRequest)
+{
+    string result;
+    if(!pvRequest) return result;
+    PVStructurePtr pvRecordOptions = pvRequest->getSubField<PVStructure>("record._options");
+    if(pvRecordOptions && !pvRecordOptions->getPVFields().empty()) {
+        result += "record";
+        appendOptions(result,pvRecordOptions);
+    }
+    const char * selections[] = {"field","putField","getField"};
+    for(size_t i=0; i<3; ++i) {
+        PVStructurePtr pvSelection = pvRequest->getSubField<PVStructure>(selections[i]);
+        if(!pvSelection) continue;
+        result += string(selections[i]) + '(';
+        appendFields(result,pvSelection,"");
+        result += ')';
+    }
+    return result;
+}
+
+string WorkloadRecorder::fieldToString(FieldConstPtr const & field)
+{
+    string result;
+    appendField(result,field);
+    return result;
+}
+
+FieldConstPtr WorkloadRecorder::stringToField(string const & value)
+{
+    FieldParser parser(value);
+    return parser.parse();
+}
+
+}}
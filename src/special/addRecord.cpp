@@ -81,7 +81,6 @@ bool AddRecord::init()
 
 void AddRecord::process()
 {
-    PVDataCreatePtr pvDataCreate = getPVDataCreate();
     string name = pvRecordName->get();
     PVRecordPtr pvRecord = PVDatabase::getMaster()->findRecord(name);
     if(pvRecord) {
@@ -103,7 +102,7 @@ void AddRecord::process()
         return;
     }
     StructureConstPtr st = static_pointer_cast<const Structure>(pvField->getField());
-    PVStructurePtr pvStructure = pvDataCreate->createPVStructure(st);
+    PVStructurePtr pvStructure = PVRecordPool::getPool()->createPVStructure(st);
     PVRecordPtr pvRec = PVRecord::create(name,pvStructure);
     bool result = PVDatabase::getMaster()->addRecord(pvRec);
     if(result) {
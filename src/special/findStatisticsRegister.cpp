@@ -0,0 +1,60 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+
+#include <iostream>
+#include <string>
+#include <iocsh.h>
+#include <pv/pvData.h>
+
+// The following must be the last include for code pvDatabase uses
+#include <epicsExport.h>
+#define epicsExportSharedSymbols
+#include "pv/pvDatabase.h"
+
+using namespace epics::pvDatabase;
+using namespace std;
+
+static const iocshArg testArg0 = { "command", iocshArgString };
+static const iocshArg *testArgs[] = {
+    &testArg0};
+
+static const iocshFuncDef findStatisticsFuncDef = {"pvdbFindStatistics", 1,testArgs};
+
+static void findStatisticsCallFunc(const iocshArgBuf *args)
+{
+    char *command = args[0].sval;
+    string value(command ? command : "");
+    PVDatabasePtr pvDatabase(PVDatabase::getMaster());
+    if(value=="clear") {
+        pvDatabase->clearFindStatistics();
+    } else if(value.empty()) {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t filtered = 0;
+        pvDatabase->getFindStatistics(hits,misses,filtered);
+        cout << "hits " << hits << " misses " << misses
+             << " filtered " << filtered << endl;
+    } else {
+        cout << "pvdbFindStatistics [clear]" << endl;
+    }
+}
+
+static void findStatisticsRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&findStatisticsFuncDef, findStatisticsCallFunc);
+    }
+}
+
+extern "C" {
+    epicsExportRegistrar(findStatisticsRegister);
+}
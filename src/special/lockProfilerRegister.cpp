@@ -0,0 +1,71 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <iocsh.h>
+
+// The following must be the last include for code pvDatabase uses
+#include <epicsExport.h>
+#define epicsExportSharedSymbols
+#include "pv/lockProfiler.h"
+
+using namespace epics::pvDatabase;
+using namespace std;
+
+static const iocshArg testArg0 = { "command", iocshArgString };
+static const iocshArg testArg1 = { "argument", iocshArgString };
+static const iocshArg *testArgs[] = {
+    &testArg0,&testArg1};
+
+static const iocshFuncDef lockProfilerFuncDef = {"pvdbLockProfiler", 2,testArgs};
+
+static void lockProfilerCallFunc(const iocshArgBuf *args)
+{
+    char *command = args[0].sval;
+    char *argument = args[1].sval;
+    string value(command ? command : "");
+    if(value=="enable") {
+        unsigned int interval = argument ? strtoul(argument,0,10) : 16;
+        LockProfiler::enable(interval);
+    } else if(value=="disable") {
+        LockProfiler::disable();
+    } else if(value=="clear") {
+        LockProfiler::clear();
+    } else if(value=="report") {
+        size_t number = argument ? strtoul(argument,0,10) : 10;
+        LockProfiler::report(cout,number);
+    } else if(value=="dump") {
+        if(!argument) {
+            cout << "pvdbLockProfiler dump fileName" << endl;
+            return;
+        }
+        if(!LockProfiler::dumpFolded(argument)) {
+            cout << "pvdbLockProfiler could not write " << argument << endl;
+        }
+    } else {
+        cout << "pvdbLockProfiler enable [sampleInterval] | disable | clear"
+             << " | report [number] | dump fileName" << endl;
+    }
+}
+
+static void lockProfilerRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&lockProfilerFuncDef, lockProfilerCallFunc);
+    }
+}
+
+extern "C" {
+    epicsExportRegistrar(lockProfilerRegister);
+}
@@ -14,9 +14,15 @@
 #include <shareLib.h>
 #include <string>
 #include <cstring>
+#include <cstdlib>
 #include <stdexcept>
 #include <memory>
 #include <set>
+#include <sstream>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include <pv/lock.h>
 #include <pv/pvType.h>
@@ -32,6 +38,8 @@
 #include "pv/pvStructureCopy.h"
 #include "pv/pvDatabase.h"
 #include "pv/processRecord.h"
+#include "pv/timeStampService.h"
+#include "pv/lockProfiler.h"
 
 using std::tr1::static_pointer_cast;
 using namespace epics::pvData;
@@ -42,6 +50,13 @@ namespace epics { namespace pvDatabase {
 
 ProcessRecordPtr ProcessRecord::create(
     std::string const & recordName,double delay)
+{
+    return create(recordName,delay,"");
+}
+
+ProcessRecordPtr ProcessRecord::create(
+    std::string const & recordName,double delay,
+    std::string const & cpuList)
 {
     FieldCreatePtr fieldCreate = getFieldCreate();
     PVDataCreatePtr pvDataCreate = getPVDataCreate();
@@ -56,11 +71,47 @@ ProcessRecordPtr ProcessRecord::create(
         createStructure();
     PVStructurePtr pvStructure = pvDataCreate->createPVStructure(topStructure);
     ProcessRecordPtr pvRecord(
-        new ProcessRecord(recordName,pvStructure,delay));
+        new ProcessRecord(recordName,pvStructure,delay,cpuList));
     if(!pvRecord->init()) pvRecord.reset();
     return pvRecord;
 }
 
+void ProcessRecord::setAffinity()
+{
+    string const & cpus = cpuList;
+    if(cpus.empty()) return;
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    std::stringstream ss(cpus);
+    string item;
+    while(std::getline(ss,item,',')) {
+        // each item is cpu or first-last, with nothing else
+        const char * text = item.c_str();
+        char * end = 0;
+        long first = strtol(text,&end,10);
+        bool valid = (end!=text);
+        long last = first;
+        if(valid && *end=='-') {
+            const char * next = end + 1;
+            last = strtol(next,&end,10);
+            valid = (end!=next);
+        }
+        if(!valid || *end!='\0' || first<0 || last<first || last>=CPU_SETSIZE) {
+            cout << getRecordName() << " invalid cpuList " << cpus << endl;
+            return;
+        }
+        for(long cpu=first; cpu<=last; ++cpu) CPU_SET(cpu,&cpuSet);
+    }
+    int status = pthread_setaffinity_np(pthread_self(),sizeof(cpuSet),&cpuSet);
+    if(status!=0) {
+        cout << getRecordName() << " pthread_setaffinity_np failed for " << cpus << endl;
+    }
+#else
+    cout << getRecordName() << " cpuList is not supported on this platform" << endl;
+#endif
+}
+
 void ProcessRecord::startThread()
 {
     thread = EpicsThreadPtr(new epicsThread(
@@ -80,9 +131,11 @@ void ProcessRecord::stop()
 
 ProcessRecord::ProcessRecord(
     std::string const & recordName,
-    epics::pvData::PVStructurePtr const & pvStructure,double delay)
+    epics::pvData::PVStructurePtr const & pvStructure,double delay,
+    std::string const & cpuList)
 : PVRecord(recordName,pvStructure),
   delay(delay),
+  cpuList(cpuList),
   pvDatabase(PVDatabase::getMaster())
 {
 }
@@ -137,6 +190,9 @@ void ProcessRecord::process()
 
 void ProcessRecord::run()
 {
+    // records are processed and their monitors notified on this thread
+    setAffinity();
+    LockProfiler::Scope scope(LockProfiler::scan);
     while(true) {
         if(runStop.tryWait()) {
              runReturn.signal();
@@ -144,6 +200,7 @@ void ProcessRecord::run()
         }
         if(delay>0.0) epicsThreadSleep(delay);
         epicsGuard<epics::pvData::Mutex> guard(mutex);
+        TimeStampService::Batch batch;
         PVRecordMap::iterator iter;
         for(iter = pvRecordMap.begin(); iter!=pvRecordMap.end(); ++iter) {
            PVRecordPtr pvRecord = (*iter).second;
@@ -35,10 +35,11 @@ using namespace std;
 
 static const iocshArg testArg0 = { "recordName", iocshArgString };
 static const iocshArg testArg1 = { "delay", iocshArgDouble };
+static const iocshArg testArg2 = { "cpuList", iocshArgString };
 static const iocshArg *testArgs[] = {
-    &testArg0,&testArg1};
+    &testArg0,&testArg1,&testArg2};
 
-static const iocshFuncDef processRecordFuncDef = {"processRecordCreate", 2,testArgs};
+static const iocshFuncDef processRecordFuncDef = {"processRecordCreate", 3,testArgs};
 
 static void processRecordCallFunc(const iocshArgBuf *args)
 {
@@ -48,7 +49,9 @@ static void processRecordCallFunc(const iocshArgBuf *args)
     }
     double delay = args[1].dval;
     if(delay<0.0) delay = 1.0;
-    ProcessRecordPtr record = ProcessRecord::create(recordName,delay);
+    char *cpuList = args[2].sval;
+    ProcessRecordPtr record = ProcessRecord::create(
+        recordName,delay,(cpuList ? cpuList : ""));
     bool result = PVDatabase::getMaster()->addRecord(record);
     if(!result) cout << "recordname" << " not added" << endl;
 }
@@ -0,0 +1,370 @@
+/* snapshotRecord.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+#include <string>
+#include <sstream>
+#include <limits>
+#include <algorithm>
+#include <epicsThread.h>
+#include <epicsString.h>
+#include <pv/event.h>
+#include <pv/lock.h>
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+#include <pv/alarm.h>
+#include <pv/rpcService.h>
+
+#define epicsExportSharedSymbols
+#include "pv/pvDatabase.h"
+#include "pv/snapshotRecord.h"
+
+using std::tr1::static_pointer_cast;
+using namespace epics::pvData;
+using namespace epics::pvAccess;
+using namespace std;
+
+namespace epics { namespace pvDatabase {
+
+namespace {
+
+template<typename T>
+typename PVValueArray<T>::const_svector toArray(vector<T> const & values)
+{
+    typename PVValueArray<T>::svector result(values.size());
+    std::copy(values.begin(),values.end(),result.begin());
+    return freeze(result);
+}
+
+class SnapshotService :
+    public RPCService
+{
+public:
+    POINTER_DEFINITIONS(SnapshotService);
+    virtual ~SnapshotService() {}
+    virtual PVStructurePtr request(PVStructurePtr const & args);
+};
+
+PVStructurePtr SnapshotService::request(PVStructurePtr const & args)
+{
+    PVStringPtr pvPattern = args->getSubField<PVString>("pattern");
+    if(!pvPattern) {
+        throw RPCRequestException(Status::STATUSTYPE_ERROR,"argument pattern not found");
+    }
+    string fieldName("value");
+    PVStringPtr pvFieldName = args->getSubField<PVString>("fieldName");
+    if(pvFieldName && !pvFieldName->get().empty()) fieldName = pvFieldName->get();
+    SnapshotRecord::Snapshot snapshot;
+    string error = SnapshotRecord::takeSnapshot(pvPattern->get(),fieldName,snapshot);
+    if(!error.empty()) throw RPCRequestException(Status::STATUSTYPE_ERROR,error);
+    StructureConstPtr structure = getFieldCreate()->createFieldBuilder()->
+        setId("epics:nt/NTTable:1.0")->
+        addArray("labels",pvString)->
+        addNestedStructure("value")->
+            addArray("name",pvString)->
+            addArray("value",pvDouble)->
+            addArray("severity",pvInt)->
+            addArray("secondsPastEpoch",pvLong)->
+            addArray("nanoseconds",pvInt)->
+            endNested()->
+        createStructure();
+    PVStructurePtr result = getPVDataCreate()->createPVStructure(structure);
+    PVStringArray::svector labels(5);
+    labels[0] = "name";
+    labels[1] = "value";
+    labels[2] = "severity";
+    labels[3] = "secondsPastEpoch";
+    labels[4] = "nanoseconds";
+    result->getSubField<PVStringArray>("labels")->replace(freeze(labels));
+    result->getSubField<PVStringArray>("value.name")->replace(toArray(snapshot.names));
+    result->getSubField<PVDoubleArray>("value.value")->replace(toArray(snapshot.values));
+    result->getSubField<PVIntArray>("value.severity")->replace(toArray(snapshot.severities));
+    result->getSubField<PVLongArray>("value.secondsPastEpoch")->replace(toArray(snapshot.secondsPastEpoch));
+    result->getSubField<PVIntArray>("value.nanoseconds")->replace(toArray(snapshot.nanoseconds));
+    return result;
+}
+
+bool isGlob(string const & pattern)
+{
+    return pattern.find_first_of("*?")!=string::npos;
+}
+
+}
+
+SnapshotRecordPtr SnapshotRecord::create(
+    std::string const & recordName,double period)
+{
+    FieldCreatePtr fieldCreate = getFieldCreate();
+    PVDataCreatePtr pvDataCreate = getPVDataCreate();
+    StructureConstPtr  topStructure = fieldCreate->createFieldBuilder()->
+        addNestedStructure("argument")->
+            add("pattern",pvString)->
+            add("fieldName",pvString)->
+            endNested()->
+        addNestedStructure("result") ->
+            add("status",pvString) ->
+            addArray("names",pvString) ->
+            addArray("values",pvDouble) ->
+            addArray("severities",pvInt) ->
+            addArray("secondsPastEpoch",pvLong) ->
+            addArray("nanoseconds",pvInt) ->
+            endNested()->
+        add("timeStamp",getStandardField()->timeStamp()) ->
+        createStructure();
+    PVStructurePtr pvStructure = pvDataCreate->createPVStructure(topStructure);
+    SnapshotRecordPtr pvRecord(
+        new SnapshotRecord(recordName,pvStructure,period));
+    if(!pvRecord->init()) pvRecord.reset();
+    return pvRecord;
+}
+
+SnapshotRecord::SnapshotRecord(
+    std::string const & recordName,
+    epics::pvData::PVStructurePtr const & pvStructure,double period)
+: PVRecord(recordName,pvStructure),
+  period(period),
+  lastGeneration(0)
+{
+}
+
+SnapshotRecord::~SnapshotRecord()
+{
+    stop();
+}
+
+bool SnapshotRecord::init()
+{
+    initPVRecord();
+    PVStructurePtr pvStructure = getPVStructure();
+    pvPattern = pvStructure->getSubField<PVString>("argument.pattern");
+    if(!pvPattern) return false;
+    pvFieldName = pvStructure->getSubField<PVString>("argument.fieldName");
+    if(!pvFieldName) return false;
+    pvFieldName->put("value");
+    pvStatus = pvStructure->getSubField<PVString>("result.status");
+    pvNames = pvStructure->getSubField<PVStringArray>("result.names");
+    pvValues = pvStructure->getSubField<PVDoubleArray>("result.values");
+    pvSeverities = pvStructure->getSubField<PVIntArray>("result.severities");
+    pvSecondsPastEpoch = pvStructure->getSubField<PVLongArray>("result.secondsPastEpoch");
+    pvNanoseconds = pvStructure->getSubField<PVIntArray>("result.nanoseconds");
+    if(!pvStatus || !pvNames || !pvValues || !pvSeverities
+    || !pvSecondsPastEpoch || !pvNanoseconds) return false;
+    if(period>0.0) {
+        thread = std::tr1::shared_ptr<epicsThread>(new epicsThread(
+            *this,
+            "snapshotRecord",
+            epicsThreadGetStackSize(epicsThreadStackSmall),
+            epicsThreadPriorityLow));
+        thread->start();
+    }
+    return true;
+}
+
+string SnapshotRecord::findEntries(
+    string const & pattern,
+    string const & fieldName,
+    string const & skipName,
+    vector<string> & names,
+    vector<Entry> & entries)
+{
+    names.clear();
+    entries.clear();
+    PVDatabasePtr pvDatabase = PVDatabase::getMaster();
+    vector<string> items;
+    bool glob = false;
+    std::stringstream ss(pattern);
+    string item;
+    while(std::getline(ss,item,',')) {
+        if(item.empty()) continue;
+        items.push_back(item);
+        if(isGlob(item)) glob = true;
+    }
+    if(items.empty()) return "pattern is empty";
+    vector<string> candidates;
+    if(glob) {
+        PVStringArrayPtr recordNames = pvDatabase->getRecordNames();
+        PVStringArray::const_svector view = recordNames->view();
+        for(size_t i=0; i<view.size(); ++i) {
+            for(size_t j=0; j<items.size(); ++j) {
+                if(epicsStrGlobMatch(view[i].c_str(),items[j].c_str())) {
+                    candidates.push_back(view[i]);
+                    break;
+                }
+            }
+        }
+    } else {
+        candidates = items;
+    }
+    for(size_t i=0; i<candidates.size(); ++i) {
+        if(candidates[i]==skipName) continue;
+        PVRecordPtr pvRecord = pvDatabase->findRecord(candidates[i]);
+        if(!pvRecord) continue;
+        // an alias of the record itself
+        if(pvRecord->getRecordName()==skipName) continue;
+        PVStructurePtr pvStructure = pvRecord->getPVStructure();
+        Entry entry;
+        entry.pvValue = pvStructure->getSubField<PVScalar>(fieldName);
+        if(!entry.pvValue) continue;
+        entry.pvRecord = pvRecord;
+        entry.pvSeverity = pvStructure->getSubField<PVInt>("alarm.severity");
+        entry.pvSecondsPastEpoch = pvStructure->getSubField<PVLong>("timeStamp.secondsPastEpoch");
+        entry.pvNanoseconds = pvStructure->getSubField<PVInt>("timeStamp.nanoseconds");
+        names.push_back(candidates[i]);
+        entries.push_back(entry);
+    }
+    return "";
+}
+
+void SnapshotRecord::copyEntries(
+    vector<Entry> const & entries,
+    Snapshot & snapshot,
+    PVRecordPtr const & lockedRecord)
+{
+    size_t number = entries.size();
+    snapshot.values.resize(number);
+    snapshot.severities.resize(number);
+    snapshot.secondsPastEpoch.resize(number);
+    snapshot.nanoseconds.resize(number);
+    for(size_t i=0; i<number; ++i) {
+        Entry const & entry = entries[i];
+        PVRecordPtr pvRecord(entry.pvRecord.lock());
+        double value = std::numeric_limits<double>::quiet_NaN();
+        int32 severity = invalidAlarm;
+        int64 secondsPastEpoch = 0;
+        int32 nanoseconds = 0;
+        if(pvRecord) {
+            // a caller that holds the lock of lockedRecord takes the others
+            // in the order of lockOtherRecord, so two snapshots can not deadlock
+            if(lockedRecord) {
+                lockedRecord->lockOtherRecord(pvRecord);
+            } else {
+                pvRecord->lock();
+            }
+            try {
+                if(entry.pvValue->getScalar()->getScalarType()==pvDouble) {
+                    value = static_cast<PVDouble &>(*entry.pvValue).get();
+                } else {
+                    value = entry.pvValue->getAs<double>();
+                }
+                severity = entry.pvSeverity ? entry.pvSeverity->get() : 0;
+            } catch(std::exception &) {
+                // a string that is not a number
+            }
+            secondsPastEpoch = entry.pvSecondsPastEpoch ? entry.pvSecondsPastEpoch->get() : 0;
+            nanoseconds = entry.pvNanoseconds ? entry.pvNanoseconds->get() : 0;
+            pvRecord->unlock();
+        }
+        snapshot.values[i] = value;
+        snapshot.severities[i] = severity;
+        snapshot.secondsPastEpoch[i] = secondsPastEpoch;
+        snapshot.nanoseconds[i] = nanoseconds;
+    }
+}
+
+string SnapshotRecord::takeSnapshot(
+    string const & pattern,
+    string const & fieldName,
+    Snapshot & snapshot)
+{
+    vector<Entry> entries;
+    string error = findEntries(pattern,fieldName,"",snapshot.names,entries);
+    if(!error.empty()) return error;
+    copyEntries(entries,snapshot,PVRecordPtr());
+    return "";
+}
+
+string SnapshotRecord::update(
+    string const & pattern,
+    string const & fieldName,
+    Snapshot & snapshot,
+    PVRecordPtr const & lockedRecord)
+{
+    vector<Entry> current;
+    {
+        epicsGuard<epics::pvData::Mutex> guard(mutex);
+        // read before the search, so that a change during the search is seen next time
+        size_t generation = PVDatabase::getMaster()->getGeneration();
+        if(pattern!=lastPattern || fieldName!=lastFieldName || generation!=lastGeneration) {
+            lastPattern = pattern;
+            lastFieldName = fieldName;
+            lastGeneration = generation;
+            string error = findEntries(pattern,fieldName,getRecordName(),names,entries);
+            if(!error.empty()) {
+                lastPattern.clear();
+                return error;
+            }
+        }
+        snapshot.names = names;
+        current = entries;
+    }
+    copyEntries(current,snapshot,lockedRecord);
+    return "";
+}
+
+void SnapshotRecord::publish(string const & status,Snapshot const & snapshot)
+{
+    pvStatus->put(status);
+    pvNames->replace(toArray(snapshot.names));
+    pvValues->replace(toArray(snapshot.values));
+    pvSeverities->replace(toArray(snapshot.severities));
+    pvSecondsPastEpoch->replace(toArray(snapshot.secondsPastEpoch));
+    pvNanoseconds->replace(toArray(snapshot.nanoseconds));
+}
+
+void SnapshotRecord::process()
+{
+    // called with this record locked
+    Snapshot snapshot;
+    string error = update(pvPattern->get(),pvFieldName->get(),snapshot,shared_from_this());
+    PVRecord::process();
+    publish(error.empty() ? "success" : error,snapshot);
+}
+
+RPCServiceAsync::shared_pointer SnapshotRecord::getService(
+    PVStructurePtr const & pvRequest)
+{
+    return SnapshotService::shared_pointer(new SnapshotService());
+}
+
+void SnapshotRecord::run()
+{
+    while(true) {
+        if(runStop.wait(period)) {
+            runReturn.signal();
+            return;
+        }
+        if(isRemoved()) continue;
+        string pattern;
+        string fieldName;
+        {
+            epicsGuard<PVRecord> guard(*this);
+            pattern = pvPattern->get();
+            fieldName = pvFieldName->get();
+        }
+        if(pattern.empty()) continue;
+        // the other records are locked one at a time without holding this record's lock
+        Snapshot snapshot;
+        string error = update(pattern,fieldName,snapshot,PVRecordPtr());
+        epicsGuard<PVRecord> guard(*this);
+        beginGroupPut();
+        PVRecord::process();
+        publish(error.empty() ? "success" : error,snapshot);
+        endGroupPut();
+    }
+}
+
+void SnapshotRecord::stop()
+{
+    if(!thread) return;
+    runStop.signal();
+    runReturn.wait();
+    thread.reset();
+}
+
+}}
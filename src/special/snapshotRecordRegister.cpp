@@ -0,0 +1,61 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+
+#include <epicsThread.h>
+#include <iocsh.h>
+#include <pv/event.h>
+#include <pv/pvAccess.h>
+#include <pv/serverContext.h>
+#include <pv/pvData.h>
+#include <pv/rpcService.h>
+
+// The following must be the last include for code pvDatabase uses
+#include <epicsExport.h>
+#define epicsExportSharedSymbols
+#include "pv/pvDatabase.h"
+#include "pv/snapshotRecord.h"
+
+using namespace epics::pvData;
+using namespace epics::pvAccess;
+using namespace epics::pvDatabase;
+using namespace std;
+
+static const iocshArg testArg0 = { "recordName", iocshArgString };
+static const iocshArg testArg1 = { "period", iocshArgDouble };
+static const iocshArg *testArgs[] = {
+    &testArg0,&testArg1};
+
+static const iocshFuncDef snapshotRecordFuncDef = {"snapshotRecordCreate", 2,testArgs};
+
+static void snapshotRecordCallFunc(const iocshArgBuf *args)
+{
+    char *recordName = args[0].sval;
+    if(!recordName) {
+        throw std::runtime_error("snapshotRecordCreate invalid number of arguments");
+    }
+    double period = args[1].dval;
+    if(period<0.0) period = 0.0;
+    SnapshotRecordPtr record = SnapshotRecord::create(recordName,period);
+    bool result = PVDatabase::getMaster()->addRecord(record);
+    if(!result) cout << "recordname" << " not added" << endl;
+}
+
+static void snapshotRecordRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&snapshotRecordFuncDef, snapshotRecordCallFunc);
+    }
+}
+
+extern "C" {
+    epicsExportRegistrar(snapshotRecordRegister);
+}
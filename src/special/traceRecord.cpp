@@ -28,6 +28,7 @@
 #define epicsExportSharedSymbols
 #include "pv/pvStructureCopy.h"
 #include "pv/channelProviderLocal.h"
+#include "pv/traceLog.h"
 #include "pv/traceRecord.h"
 
 using std::tr1::static_pointer_cast;
@@ -46,6 +47,7 @@ TraceRecordPtr TraceRecord::create(
         addNestedStructure("argument")->
             add("recordName",pvString)->
             add("level",pvInt)->
+            add("structured",pvBoolean)->
             endNested()->
         addNestedStructure("result") ->
             add("status",pvString) ->
@@ -74,6 +76,8 @@ bool TraceRecord::init()
     if(!pvRecordName) return false;
     pvLevel = pvStructure->getSubField<PVInt>("argument.level");
     if(!pvLevel) return false;
+    pvStructured = pvStructure->getSubField<PVBoolean>("argument.structured");
+    if(!pvStructured) return false;
     pvResult = pvStructure->getSubField<PVString>("result.status");
     if(!pvResult) return false;
     return true;
@@ -88,6 +92,12 @@ void TraceRecord::process()
         return;
     }
     pvRecord->setTraceLevel(pvLevel->get());
+    bool structured = pvStructured->get();
+    TraceLog::enableRecord(*pvRecord,structured);
+    if(structured && !TraceLog::isActive()) {
+        pvResult->put("success but TraceLog not started");
+        return;
+    }
     pvResult->put("success");
 }
 
@@ -26,6 +26,7 @@
 #include "pv/pvStructureCopy.h"
 #include "pv/pvDatabase.h"
 #include "pv/traceRecord.h"
+#include "pv/traceLog.h"
 
 using namespace epics::pvData;
 using namespace epics::pvAccess;
@@ -49,12 +50,43 @@ static void traceRecordCallFunc(const iocshArgBuf *args)
     if(!result) cout << "recordname" << " not added" << endl;
 }
 
+static const iocshArg traceStartArg0 = { "fileName", iocshArgString };
+static const iocshArg traceStartArg1 = { "ringSize", iocshArgInt };
+static const iocshArg *traceStartArgs[] = {
+    &traceStartArg0,&traceStartArg1};
+
+static const iocshFuncDef traceStartFuncDef = {"pvdbTraceStart", 2,traceStartArgs};
+
+static void traceStartCallFunc(const iocshArgBuf *args)
+{
+    char *fileName = args[0].sval;
+    if(!fileName) {
+        cout << "pvdbTraceStart fileName [ringSize]" << endl;
+        return;
+    }
+    int ringSize = args[1].ival;
+    if(ringSize<=0) ringSize = 8192;
+    if(!TraceLog::start(fileName,ringSize)) {
+        cout << "pvdbTraceStart already started or could not open " << fileName << endl;
+    }
+}
+
+static const iocshFuncDef traceStopFuncDef = {"pvdbTraceStop", 0,0};
+
+static void traceStopCallFunc(const iocshArgBuf *args)
+{
+    TraceLog::stop();
+    cout << "dropped events " << TraceLog::getDropped() << endl;
+}
+
 static void traceRecordRegister(void)
 {
     static int firstTime = 1;
     if (firstTime) {
         firstTime = 0;
         iocshRegister(&traceRecordFuncDef, traceRecordCallFunc);
+        iocshRegister(&traceStartFuncDef, traceStartCallFunc);
+        iocshRegister(&traceStopFuncDef, traceStopCallFunc);
     }
 }
 
@@ -0,0 +1,58 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+
+/**
+ * @author mrk
+ * @date 2026.10.17
+ */
+
+#include <iostream>
+#include <string>
+#include <iocsh.h>
+
+// The following must be the last include for code pvDatabase uses
+#include <epicsExport.h>
+#define epicsExportSharedSymbols
+#include "pv/workloadRecorder.h"
+
+using namespace epics::pvDatabase;
+using namespace std;
+
+static const iocshArg testArg0 = { "command", iocshArgString };
+static const iocshArg testArg1 = { "fileName", iocshArgString };
+static const iocshArg *testArgs[] = {
+    &testArg0,&testArg1};
+
+static const iocshFuncDef workloadRecorderFuncDef = {"pvdbWorkloadRecorder", 2,testArgs};
+
+static void workloadRecorderCallFunc(const iocshArgBuf *args)
+{
+    char *command = args[0].sval;
+    char *fileName = args[1].sval;
+    string value(command ? command : "");
+    if(value=="start" && fileName) {
+        if(!WorkloadRecorder::start(fileName)) {
+            cout << "pvdbWorkloadRecorder already started or could not open "
+                 << fileName << endl;
+        }
+    } else if(value=="stop") {
+        WorkloadRecorder::stop();
+    } else {
+        cout << "pvdbWorkloadRecorder start fileName | stop" << endl;
+    }
+}
+
+static void workloadRecorderRegister(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        firstTime = 0;
+        iocshRegister(&workloadRecorderFuncDef, workloadRecorderCallFunc);
+    }
+}
+
+extern "C" {
+    epicsExportRegistrar(workloadRecorderRegister);
+}
@@ -17,6 +17,8 @@ int testPlugin(void);
 int testPVRecord(void);
 int testLocalProvider(void);
 int testPVAServer(void);
+int testSnapshotRecord(void);
+int testPVDatabase(void);
 
 void pvDatabaseAllTests(void)
 {
@@ -29,6 +31,8 @@ void pvDatabaseAllTests(void)
     runTest(testPVRecord);
     runTest(testLocalProvider);
     runTest(testPVAServer);
+    runTest(testSnapshotRecord);
+    runTest(testPVDatabase);
 
     epicsExit(0);   /* Trigger test harness */
 }
@@ -30,6 +30,9 @@
 #include <pv/standardPVField.h>
 #include <pv/pvData.h>
 #include <pv/pvAccess.h>
+#include <pv/createRequest.h>
+#include <pv/event.h>
+#include <pv/pvStructureCopy.h>
 #include <pv/channelProviderLocal.h>
 #include <pv/serverContext.h>
 #include "recordClient.h"
@@ -40,9 +43,134 @@ using std::tr1::static_pointer_cast;
 using namespace epics::pvData;
 using namespace epics::pvAccess;
 using namespace epics::pvDatabase;
+using namespace epics::pvCopy;
 
 static bool debug = false;
 
+class TestChannelRequester : public ChannelRequester
+{
+public:
+    POINTER_DEFINITIONS(TestChannelRequester);
+    TestChannelRequester() : numberDestroyed(0) {}
+    virtual ~TestChannelRequester() {}
+    virtual string getRequesterName() { return "testLocalProvider"; }
+    virtual void channelCreated(
+        const Status& status,
+        Channel::shared_pointer const & channel)
+    {
+        statusOK.push_back(status.isOK());
+        channelNames.push_back(channel ? channel->getChannelName() : string());
+    }
+    virtual void channelStateChange(
+        Channel::shared_pointer const & channel,
+        Channel::ConnectionState connectionState)
+    {
+        if(connectionState==Channel::DESTROYED) ++numberDestroyed;
+    }
+    vector<bool> statusOK;
+    vector<string> channelNames;
+    size_t numberDestroyed;
+};
+
+
+class TestGetRequester : public ChannelGetRequester
+{
+public:
+    POINTER_DEFINITIONS(TestGetRequester);
+    TestGetRequester() : numberGets(0) {}
+    virtual ~TestGetRequester() {}
+    virtual string getRequesterName() { return "testLocalProvider"; }
+    virtual void channelGetConnect(
+        const Status& status,
+        ChannelGet::shared_pointer const & channelGet,
+        StructureConstPtr const & structure) {}
+    virtual void getDone(
+        const Status& status,
+        ChannelGet::shared_pointer const & channelGet,
+        PVStructurePtr const & pvStructure,
+        BitSetPtr const & bitSet)
+    {
+        if(status.isOK()) ++numberGets;
+    }
+    size_t numberGets;
+};
+
+class TestProcessRequester : public ChannelProcessRequester
+{
+public:
+    POINTER_DEFINITIONS(TestProcessRequester);
+    TestProcessRequester() : numberDone(0), numberErrors(0) {}
+    virtual ~TestProcessRequester() {}
+    virtual string getRequesterName() { return "testLocalProvider"; }
+    virtual void channelProcessConnect(
+        const Status& status,
+        ChannelProcess::shared_pointer const & channelProcess) {}
+    virtual void processDone(
+        const Status& status,
+        ChannelProcess::shared_pointer const & channelProcess)
+    {
+        if(!status.isOK()) {
+            ++numberErrors;
+            return;
+        }
+        ++numberDone;
+        done.signal();
+    }
+    size_t numberDone;
+    size_t numberErrors;
+    Event done;
+};
+
+class TestArrayRequester : public ChannelArrayRequester
+{
+public:
+    POINTER_DEFINITIONS(TestArrayRequester);
+    TestArrayRequester() : numberGets(0) {}
+    virtual ~TestArrayRequester() {}
+    virtual string getRequesterName() { return "testLocalProvider"; }
+    virtual void channelArrayConnect(
+        const Status& status,
+        ChannelArray::shared_pointer const & channelArray,
+        Array::const_shared_pointer const & array) {}
+    virtual void putArrayDone(
+        const Status& status,
+        ChannelArray::shared_pointer const & channelArray) {}
+    virtual void getArrayDone(
+        const Status& status,
+        ChannelArray::shared_pointer const & channelArray,
+        PVArray::shared_pointer const & pvArray)
+    {
+        if(!status.isOK()) return;
+        ++numberGets;
+        this->pvArray = static_pointer_cast<PVDoubleArray>(pvArray);
+    }
+    virtual void getLengthDone(
+        const Status& status,
+        ChannelArray::shared_pointer const & channelArray,
+        size_t length) {}
+    virtual void setLengthDone(
+        const Status& status,
+        ChannelArray::shared_pointer const & channelArray) {}
+    size_t numberGets;
+    PVDoubleArrayPtr pvArray;
+};
+
+class GroupPutCounter : public PVListener
+{
+public:
+    POINTER_DEFINITIONS(GroupPutCounter);
+    GroupPutCounter() : numberGroupPuts(0) {}
+    virtual ~GroupPutCounter() {}
+    virtual void detach(PVRecordPtr const & pvRecord) {}
+    virtual void dataPut(PVRecordFieldPtr const & pvRecordField) {}
+    virtual void dataPut(
+        PVRecordStructurePtr const & requested,
+        PVRecordFieldPtr const & pvRecordField) {}
+    virtual void beginGroupPut(PVRecordPtr const & pvRecord) {}
+    virtual void endGroupPut(PVRecordPtr const & pvRecord) { ++numberGroupPuts;}
+    virtual void unlisten(PVRecordPtr const & pvRecord) {}
+    size_t numberGroupPuts;
+};
 
 static void test()
 {
@@ -73,9 +201,260 @@ static void test()
     if(debug) {cout << "processed exampleDouble "  << endl; }
 }
 
+static void clientTest()
+{
+    if(debug) {cout << endl << endl << "****clientTest****" << endl; }
+    PVDatabasePtr master = PVDatabase::getMaster();
+    ChannelProviderLocalPtr channelProvider = getChannelProviderLocal();
+    PVStructurePtr pvStructure(getStandardPVField()->scalar(pvDouble,"alarm,timeStamp"));
+    PVRecordPtr pvRecord(PVRecord::create("clientDouble",pvStructure));
+    master->addRecord(pvRecord);
+    TestChannelRequester::shared_pointer requester(new TestChannelRequester());
+    Channel::shared_pointer channel =
+        channelProvider->createChannel("clientDouble",requester,0);
+    testOk1(channel.get()!=0);
+    testOk1(pvRecord->getNumberClients()==1);
+    Channel::shared_pointer other =
+        channelProvider->createChannel("clientDouble",requester,0);
+    testOk1(pvRecord->getNumberClients()==2);
+    // a destroyed channel gives its slot back through removePVRecordClient
+    channel.reset();
+    testOk1(pvRecord->getNumberClients()==1);
+    other.reset();
+    testOk1(pvRecord->getNumberClients()==0);
+    channel = channelProvider->createChannel("clientDouble",requester,0);
+    testOk1(pvRecord->getNumberClients()==1);
+    channel.reset();
+    master->removeRecord(pvRecord);
+}
+
+static void poolClientTest()
+{
+    if(debug) {cout << endl << endl << "****poolClientTest****" << endl; }
+    PVDatabasePtr master = PVDatabase::getMaster();
+    ChannelProviderLocalPtr channelProvider = getChannelProviderLocal();
+    PVRecordPoolPtr pool = PVRecordPool::getPool();
+    StructureConstPtr structure =
+        getStandardField()->scalar(pvDouble,"alarm,timeStamp");
+    size_t numberFree = pool->getNumberFree(structure);
+    PVStructurePtr pvStructure = pool->createPVStructure(structure);
+    PVStructure * address = pvStructure.get();
+    PVRecordPtr pvRecord(PVRecord::create("poolClientDouble",pvStructure));
+    pvStructure.reset();
+    master->addRecord(pvRecord);
+    TestChannelRequester::shared_pointer requester(new TestChannelRequester());
+    Channel::shared_pointer channel =
+        channelProvider->createChannel("poolClientDouble",requester,0);
+    testOk1(channel.get()!=0);
+    testOk1(master->removeRecord(pvRecord));
+    testOk1(requester->numberDestroyed==1);
+    testOk1(pvRecord->getNumberClients()==0);
+    // the channel outlives the record but does not keep its data
+    pvRecord.reset();
+    testOk1(pool->getNumberFree(structure)==numberFree+1);
+    pvStructure = pool->createPVStructure(structure);
+    testOk1(pvStructure.get()==address);
+    channel.reset();
+}
+
+static void poolCacheTest()
+{
+    if(debug) {cout << endl << endl << "****poolCacheTest****" << endl; }
+    PVDatabasePtr master = PVDatabase::getMaster();
+    ChannelProviderLocalPtr channelProvider = getChannelProviderLocal();
+    PVRecordPoolPtr pool = PVRecordPool::getPool();
+    StructureConstPtr structure =
+        getStandardField()->scalar(pvDouble,"alarm,timeStamp");
+    size_t numberFree = pool->getNumberFree(structure);
+    PVStructurePtr pvStructure = pool->createPVStructure(structure);
+    PVStructure * address = pvStructure.get();
+    PVRecordPtr pvRecord(PVRecord::create("poolCacheDouble",pvStructure));
+    pvStructure.reset();
+    master->addRecord(pvRecord);
+    TestChannelRequester::shared_pointer requester(new TestChannelRequester());
+    Channel::shared_pointer channel =
+        channelProvider->createChannel("poolCacheDouble",requester,0);
+    TestGetRequester::shared_pointer getRequester(new TestGetRequester());
+    // the PVCopy of the request stays in the record cache after the get is gone
+    ChannelGet::shared_pointer channelGet = channel->createChannelGet(
+        getRequester,CreateRequest::create()->createRequest("value,alarm"));
+    testOk1(channelGet.get()!=0);
+    channelGet->get();
+    testOk1(getRequester->numberGets==1);
+    channelGet.reset();
+    channel.reset();
+    testOk1(master->removeRecord(pvRecord));
+    pvRecord.reset();
+    testOk1(pool->getNumberFree(structure)==numberFree+1);
+    pvStructure = pool->createPVStructure(structure);
+    testOk1(pvStructure.get()==address);
+}
+
+static void createChannelsTest()
+{
+    if(debug) {cout << endl << endl << "****createChannelsTest****" << endl; }
+    PVDatabasePtr master = PVDatabase::getMaster();
+    ChannelProviderLocalPtr channelProvider = getChannelProviderLocal();
+    PVRecordPtr first(PVRecord::create("channelsA",
+        getStandardPVField()->scalar(pvDouble,"alarm,timeStamp")));
+    PVRecordPtr second(PVRecord::create("channelsB",
+        getStandardPVField()->scalar(pvDouble,"alarm,timeStamp")));
+    master->addRecord(first);
+    master->addRecord(second);
+    // not sorted, with a missing name and a duplicate name
+    vector<string> names;
+    names.push_back("channelsB");
+    names.push_back("channelsMissing");
+    names.push_back("channelsA");
+    names.push_back("channelsB");
+    vector<PVRecordPtr> records;
+    testOk1(master->findRecords(names,records)==3);
+    testOk1(records.size()==4);
+    testOk1(records[0]==second && !records[1] && records[2]==first && records[3]==second);
+    TestChannelRequester::shared_pointer requester(new TestChannelRequester());
+    vector<Channel::shared_pointer> channels;
+    testOk1(channelProvider->createChannels(names,requester,0,channels)==3);
+    testOk1(channels.size()==4);
+    testOk1(channels[0] && channels[0]->getChannelName()=="channelsB");
+    testOk1(!channels[1]);
+    testOk1(channels[2] && channels[2]->getChannelName()=="channelsA");
+    testOk1(channels[3] && channels[3]->getChannelName()=="channelsB");
+    testOk1(channels[0]!=channels[3]);
+    // channelCreated is called once for each name, in order
+    testOk1(requester->channelNames.size()==4);
+    testOk1(requester->channelNames[0]=="channelsB"
+        && requester->channelNames[1].empty()
+        && requester->channelNames[2]=="channelsA"
+        && requester->channelNames[3]=="channelsB");
+    testOk1(requester->statusOK.size()==4);
+    testOk1(requester->statusOK[0] && !requester->statusOK[1]
+        && requester->statusOK[2] && requester->statusOK[3]);
+    testOk1(second->getNumberClients()==2 && first->getNumberClients()==1);
+    channels.clear();
+    testOk1(second->getNumberClients()==0 && first->getNumberClients()==0);
+    // no names, no channels and no callbacks
+    testOk1(channelProvider->createChannels(vector<string>(),requester,0,channels)==0);
+    testOk1(channels.empty() && requester->channelNames.size()==4);
+    master->removeRecord(first);
+    master->removeRecord(second);
+}
+
+static void processTest()
+{
+    if(debug) {cout << endl << endl << "****processTest****" << endl; }
+    PVDatabasePtr master = PVDatabase::getMaster();
+    ChannelProviderLocalPtr channelProvider = getChannelProviderLocal();
+    PVRecordPtr pvRecord(PVRecord::create("processDouble",
+        getStandardPVField()->scalar(pvDouble,"alarm,timeStamp")));
+    master->addRecord(pvRecord);
+    GroupPutCounter::shared_pointer counter(new GroupPutCounter());
+    PVCopyPtr pvCopy = PVCopy::create(
+        pvRecord->getPVStructure(),
+        CreateRequest::create()->createRequest("value"),
+        "");
+    pvRecord->addListener(counter,pvCopy);
+    TestChannelRequester::shared_pointer requester(new TestChannelRequester());
+    Channel::shared_pointer channel =
+        channelProvider->createChannel("processDouble",requester,0);
+    // the group puts that a listener sees for each batch mode
+    const char * requests[] = {
+        "record[nProcess=3]",
+        "record[nProcess=3,batch=true]",
+        "record[nProcess=3,batch=lock]"};
+    size_t groupPuts[] = {3,1,3};
+    TestProcessRequester::shared_pointer syncRequester(new TestProcessRequester());
+    for(size_t i=0; i<3; ++i) {
+        counter->numberGroupPuts = 0;
+        ChannelProcess::shared_pointer channelProcess = channel->createChannelProcess(
+            syncRequester,CreateRequest::create()->createRequest(requests[i]));
+        channelProcess->process();
+        testOk1(syncRequester->numberDone==i+1 && counter->numberGroupPuts==groupPuts[i]);
+    }
+    // async completes via processDone on a pool thread
+    TestProcessRequester::shared_pointer asyncRequester(new TestProcessRequester());
+    ChannelProcess::shared_pointer channelProcess = channel->createChannelProcess(
+        asyncRequester,CreateRequest::create()->createRequest("record[async=true]"));
+    testOk1(channelProcess.get()!=0);
+    counter->numberGroupPuts = 0;
+    pvRecord->lock();
+    channelProcess->process();
+    // the first process is queued or waits for the lock, so the second is rejected
+    channelProcess->process();
+    testOk1(asyncRequester->numberErrors==1);
+    pvRecord->unlock();
+    testOk1(asyncRequester->done.wait(10.0));
+    testOk1(asyncRequester->numberDone==1 && counter->numberGroupPuts==1);
+    // the channel and the process are released while the job is queued
+    std::tr1::weak_ptr<ChannelProcess> released(channelProcess);
+    pvRecord->lock();
+    channelProcess->process();
+    channelProcess.reset();
+    channel.reset();
+    pvRecord->unlock();
+    testOk1(asyncRequester->done.wait(10.0));
+    testOk1(asyncRequester->numberDone==2 && asyncRequester->numberErrors==1);
+    // the job drops its reference after processDone returns
+    for(int i=0; i<100 && !released.expired(); ++i) epicsThreadSleep(.01);
+    testOk1(released.expired());
+    pvRecord->removeListener(counter,pvCopy);
+    master->removeRecord(pvRecord);
+}
+
+static void channelArrayTest()
+{
+    if(debug) {cout << endl << endl << "****channelArrayTest****" << endl; }
+    PVDatabasePtr master = PVDatabase::getMaster();
+    ChannelProviderLocalPtr channelProvider = getChannelProviderLocal();
+    PVRecordPtr pvRecord(PVRecord::create("arrayDouble",
+        getStandardPVField()->scalarArray(pvDouble,"")));
+    master->addRecord(pvRecord);
+    PVDoubleArrayPtr pvValue = pvRecord->getPVStructure()->getSubField<PVDoubleArray>("value");
+    shared_vector<double> values(10);
+    for(size_t i=0; i<values.size(); i++) values[i] = i + .5;
+    {
+        epicsGuard<PVRecord> guard(*pvRecord);
+        pvValue->replace(freeze(values));
+    }
+    TestChannelRequester::shared_pointer requester(new TestChannelRequester());
+    Channel::shared_pointer channel =
+        channelProvider->createChannel("arrayDouble",requester,0);
+    TestArrayRequester::shared_pointer arrayRequester(new TestArrayRequester());
+    ChannelArray::shared_pointer channelArray = channel->createChannelArray(
+        arrayRequester,CreateRequest::create()->createRequest("value"));
+    testOk1(channelArray.get()!=0);
+    channelArray->getArray(2,3,1);
+    testOk1(arrayRequester->numberGets==1);
+    PVDoubleArray::const_svector delivered(arrayRequester->pvArray->view());
+    testOk1(delivered.size()==3);
+    testOk1(delivered[0]==2.5 && delivered[1]==3.5 && delivered[2]==4.5);
+    // a later replace on the record does not change what was delivered
+    values = shared_vector<double>(10);
+    for(size_t i=0; i<values.size(); i++) values[i] = i + 100.5;
+    {
+        epicsGuard<PVRecord> guard(*pvRecord);
+        pvValue->replace(freeze(values));
+    }
+    testOk1(delivered[0]==2.5 && delivered[2]==4.5);
+    testOk1(arrayRequester->pvArray->view()[0]==2.5);
+    // a stride other than 1 is copied
+    channelArray->getArray(1,3,2);
+    PVDoubleArray::const_svector strided(arrayRequester->pvArray->view());
+    testOk1(strided.size()==3 && strided[0]==101.5 && strided[1]==103.5 && strided[2]==105.5);
+    testOk1(delivered[0]==2.5 && delivered[2]==4.5);
+    channelArray.reset();
+    channel.reset();
+    master->removeRecord(pvRecord);
+}
+
 MAIN(testLocalProvider)
 {
-    testPlan(3);
+    testPlan(56);
     test();
+    clientTest();
+    poolClientTest();
+    poolCacheTest();
+    createChannelsTest();
+    processTest();
+    channelArrayTest();
     return 0;
 }
@@ -393,11 +393,70 @@ static void powerSupplyTest()
     testPVScalar(valueNameRecord,valueNameCopy,pvRecord,pvCopy);
 }
 
+static PVDoubleArray::const_svector createValues(size_t length,double first)
+{
+    PVDoubleArray::svector values(length);
+    for(size_t i=0; i<length; ++i) values[i] = first + i;
+    return freeze(values);
+}
+
+static void sharedBufferTest()
+{
+    if(debug) {cout << endl << endl << "****sharedBufferTest****" << endl; }
+    PVRecordPtr pvRecord = createScalarArray("sharedBufferRecord",pvDouble,"alarm");
+    PVStructurePtr pvMaster = pvRecord->getPVRecordStructure()->getPVStructure();
+    PVDoubleArrayPtr masterValue = pvMaster->getSubField<PVDoubleArray>("value");
+    masterValue->replace(createValues(5,1.0));
+    PVCopyPtr pvCopy = PVCopy::create(
+        pvMaster,CreateRequest::create()->createRequest("value"),"");
+    PVStructurePtr copy = pvCopy->createPVStructure();
+    PVDoubleArrayPtr copyValue = copy->getSubField<PVDoubleArray>("value");
+    size_t valueOffset = copyValue->getFieldOffset();
+    BitSetPtr bitSet(new BitSet(copy->getNumberFields()));
+    pvCopy->initCopy(copy,bitSet);
+    testOk1(copyValue->view().data()==masterValue->view().data());
+    // a copy that shares the master buffer is up to date
+    bitSet->clear();
+    pvCopy->updateCopySetBitSet(copy,bitSet);
+    testOk1(!bitSet->get(valueOffset));
+    bitSet->clear();
+    bitSet->set(valueOffset);
+    pvCopy->updateCopyFromBitSet(copy,bitSet);
+    testOk1(copyValue->view().data()==masterValue->view().data());
+    // a replaced master buffer is copied and reported
+    masterValue->replace(createValues(5,10.0));
+    bitSet->clear();
+    pvCopy->updateCopySetBitSet(copy,bitSet);
+    testOk1(bitSet->get(valueOffset));
+    testOk1(copyValue->view().data()==masterValue->view().data());
+    masterValue->replace(createValues(5,20.0));
+    bitSet->clear();
+    bitSet->set(valueOffset);
+    pvCopy->updateCopyFromBitSet(copy,bitSet);
+    testOk1(copyValue->view().data()==masterValue->view().data());
+    testOk1(copyValue->view()[4]==24.0);
+    // a slice has the data pointer of the master but not its size
+    PVDoubleArray::const_svector slice(masterValue->view());
+    slice.slice(0,3);
+    copyValue->replace(slice);
+    testOk1(copyValue->view().data()==masterValue->view().data());
+    bitSet->clear();
+    pvCopy->updateCopySetBitSet(copy,bitSet);
+    testOk1(bitSet->get(valueOffset));
+    testOk1(copyValue->view().size()==5);
+    copyValue->replace(slice);
+    bitSet->clear();
+    bitSet->set(valueOffset);
+    pvCopy->updateCopyFromBitSet(copy,bitSet);
+    testOk1(copyValue->view().size()==5);
+}
+
 MAIN(testPVCopy)
 {
-    testPlan(67);
+    testPlan(78);
     scalarTest();
     arrayTest();
     powerSupplyTest();
+    sharedBufferTest();
     return 0;
 }
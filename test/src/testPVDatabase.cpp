@@ -0,0 +1,166 @@
+/*testPVDatabase.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <epicsStdio.h>
+
+#include <pv/standardPVField.h>
+#include <pv/pvData.h>
+#include <pv/pvDatabase.h>
+
+using namespace std;
+using namespace epics::pvData;
+using namespace epics::pvDatabase;
+
+static bool debug = false;
+
+static PVRecordPtr createScalar(string const & recordName)
+{
+    PVStructurePtr pvStructure = getStandardPVField()->scalar(pvDouble,"alarm,timeStamp");
+    return PVRecord::create(recordName,pvStructure);
+}
+
+static string indexedName(string const & prefix,size_t index)
+{
+    char buffer[32];
+    epicsSnprintf(buffer,sizeof(buffer),"%lu",static_cast<unsigned long>(index));
+    return prefix + buffer;
+}
+
+static void findTest()
+{
+    if(debug) {cout << endl << endl << "****findTest****" << endl; }
+    PVDatabasePtr master = PVDatabase::getMaster();
+    PVRecordPtr record = createScalar("findA");
+    testOk1(master->addRecord(record));
+    master->clearFindStatistics();
+    size_t hits,misses,filtered;
+    testOk1(master->findRecord("findA")==record);
+    testOk1(!master->findRecord("findB"));
+    master->getFindStatistics(hits,misses,filtered);
+    testOk1(hits==1 && misses==1 && filtered<=1);
+    // names that were never added are rejected by the filter
+    master->clearFindStatistics();
+    for(size_t i=0; i<100; ++i) master->findRecord(indexedName("findMissing",i));
+    master->getFindStatistics(hits,misses,filtered);
+    testOk1(hits==0 && misses==100);
+    testOk1(filtered>90);
+    // an alias name passes the filter
+    testOk1(master->addAlias("findAliasA","findA"));
+    testOk1(master->findRecord("findAliasA")==record);
+    // a removed name is not found, and a name that is added again is found
+    testOk1(master->removeRecord(record));
+    testOk1(!master->findRecord("findA"));
+    testOk1(!master->findRecord("findAliasA"));
+    PVRecordPtr again = createScalar("findA");
+    testOk1(master->addRecord(again));
+    testOk1(master->findRecord("findA")==again);
+    testOk1(!master->findRecord("findAliasA"));
+    // the filter is replaced as the database grows
+    vector<PVRecordPtr> records;
+    for(size_t i=0; i<500; ++i) {
+        records.push_back(createScalar(indexedName("findGrow",i)));
+        master->addRecord(records.back());
+    }
+    bool found = true;
+    for(size_t i=0; i<records.size(); ++i) {
+        if(master->findRecord(indexedName("findGrow",i))!=records[i]) found = false;
+    }
+    testOk1(found);
+    testOk1(master->findRecord("findA")==again);
+    master->clearFindStatistics();
+    for(size_t i=0; i<100; ++i) master->findRecord(indexedName("findMissing",i));
+    master->getFindStatistics(hits,misses,filtered);
+    testOk1(filtered>90);
+    for(size_t i=0; i<records.size(); ++i) master->removeRecord(records[i]);
+    master->removeRecord(again);
+    testOk1(!master->findRecord("findGrow0") && !master->findRecord("findA"));
+}
+
+static bool hasName(PVStringArrayPtr const & names,string const & name)
+{
+    PVStringArray::const_svector view(names->view());
+    for(size_t i=0; i<view.size(); ++i) {
+        if(view[i]==name) return true;
+    }
+    return false;
+}
+
+static void aliasTest()
+{
+    if(debug) {cout << endl << endl << "****aliasTest****" << endl; }
+    PVDatabasePtr master = PVDatabase::getMaster();
+    PVRecordPtr first = createScalar("aliasA");
+    PVRecordPtr second = createScalar("aliasB");
+    master->addRecord(first);
+    master->addRecord(second);
+    // a batch with one bad entry adds nothing
+    vector<string> aliasNames;
+    vector<string> recordNames;
+    aliasNames.push_back("aliasX");
+    recordNames.push_back("aliasA");
+    aliasNames.push_back("aliasY");
+    recordNames.push_back("aliasMissing");
+    testOk1(!master->addAliases(aliasNames,recordNames));
+    testOk1(!master->findRecord("aliasX") && !master->findRecord("aliasY"));
+    recordNames[1] = "aliasB";
+    aliasNames[1] = "aliasX";
+    testOk1(!master->addAliases(aliasNames,recordNames));
+    testOk1(!master->findRecord("aliasX"));
+    // an alias can not use the name of a record or of another alias
+    testOk1(!master->addAlias("aliasB","aliasA"));
+    testOk1(master->findRecord("aliasB")==second);
+    testOk1(master->addAlias("aliasA1","aliasA"));
+    testOk1(!master->addAlias("aliasA1","aliasB"));
+    testOk1(master->findRecord("aliasA1")==first);
+    // an alias of an alias is an alias of the record
+    testOk1(master->addAlias("aliasA2","aliasA1"));
+    testOk1(master->findRecord("aliasA2")==first);
+    testOk1(master->addAlias("aliasB1","aliasB"));
+    testOk1(!hasName(master->getRecordNames(),"aliasA1"));
+    testOk1(hasName(master->getRecordNames(true),"aliasA1"));
+    // a batch with one unknown alias removes nothing
+    aliasNames.clear();
+    aliasNames.push_back("aliasA1");
+    aliasNames.push_back("aliasNone");
+    testOk1(!master->removeAliases(aliasNames));
+    testOk1(master->findRecord("aliasA1")==first);
+    aliasNames.pop_back();
+    testOk1(master->removeAliases(aliasNames));
+    testOk1(!master->findRecord("aliasA1") && master->findRecord("aliasA2")==first);
+    // the aliases of a removed record are removed, other aliases are not
+    testOk1(master->removeRecord(first));
+    testOk1(!master->findRecord("aliasA2"));
+    testOk1(!hasName(master->getRecordNames(true),"aliasA2"));
+    testOk1(master->findRecord("aliasB1")==second);
+    PVRecordPtr again = createScalar("aliasA");
+    testOk1(master->addRecord(again));
+    testOk1(!master->findRecord("aliasA2"));
+    testOk1(master->addAlias("aliasA2","aliasA"));
+    testOk1(master->findRecord("aliasA2")==again);
+    master->removeRecord(again);
+    master->removeRecord(second);
+    testOk1(!master->findRecord("aliasB1"));
+}
+
+MAIN(testPVDatabase)
+{
+    testPlan(45);
+    findTest();
+    aliasTest();
+    return 0;
+}
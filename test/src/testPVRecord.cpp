@@ -18,17 +18,22 @@
 #include <string>
 #include <cstdio>
 #include <memory>
+#include <map>
+#include <stdexcept>
 #include <iostream>
 
 #include <epicsStdio.h>
 #include <epicsMutex.h>
 #include <epicsEvent.h>
 #include <epicsThread.h>
+#include <epicsGuard.h>
 
 #include <pv/standardField.h>
 #include <pv/standardPVField.h>
 #include <pv/pvData.h>
 #include <pv/pvStructureCopy.h>
+#include <pv/createRequest.h>
+#include <pv/event.h>
 #define epicsExportSharedSymbols
 #include "powerSupply.h"
 
@@ -42,6 +47,57 @@ using std::string;
 
 static bool debug = false;
 
+class CountingListener;
+typedef std::tr1::shared_ptr<CountingListener> CountingListenerPtr;
+
+class CountingListener : public PVListener
+{
+public:
+    POINTER_DEFINITIONS(CountingListener);
+    CountingListener(bool bitSet = false)
+    : bitSet(bitSet),
+      numberFieldPuts(0),
+      numberParentPuts(0),
+      numberBitSetPuts(0)
+    {}
+    virtual ~CountingListener() {}
+    virtual void detach(PVRecordPtr const & pvRecord) {}
+    virtual void dataPut(PVRecordFieldPtr const & pvRecordField)
+    {
+        ++numberFieldPuts;
+    }
+    virtual void dataPut(
+        PVRecordStructurePtr const & requested,
+        PVRecordFieldPtr const & pvRecordField)
+    {
+        ++numberParentPuts;
+    }
+    virtual bool isBitSetListener() { return bitSet;}
+    virtual void dataPut(
+        PVRecordPtr const & pvRecord,
+        BitSet const & changed)
+    {
+        ++numberBitSetPuts;
+        this->changed = changed;
+    }
+    virtual void beginGroupPut(PVRecordPtr const & pvRecord) {}
+    virtual void endGroupPut(PVRecordPtr const & pvRecord) {}
+    virtual void unlisten(PVRecordPtr const & pvRecord) {}
+    bool bitSet;
+    int numberFieldPuts;
+    int numberParentPuts;
+    int numberBitSetPuts;
+    BitSet changed;
+};
+
+static PVCopyPtr createPVCopy(PVRecordPtr const & pvRecord,string const & request)
+{
+    return PVCopy::create(
+        pvRecord->getPVRecordStructure()->getPVStructure(),
+        CreateRequest::create()->createRequest(request),
+        "");
+}
+
 static PVRecordPtr createScalar(
     string const & recordName,
     ScalarType scalarType,
@@ -95,11 +151,244 @@ static void powerSupplyTest()
     }
 }
 
+static void poolTest()
+{
+    if(debug) {cout << endl << endl << "****poolTest****" << endl; }
+    PVRecordPoolPtr pool = PVRecordPool::getPool();
+    StructureConstPtr structure =
+        getStandardField()->scalar(pvDouble,"alarm,timeStamp");
+    PVStructurePtr pvStructure = pool->createPVStructure(structure);
+    PVStructure * address = pvStructure.get();
+    PVRecordPtr pvRecord = PVRecord::create("poolRecord1",pvStructure);
+    pvStructure.reset();
+    testOk1(pvRecord.get()!=0);
+    pvRecord->getPVStructure()->getSubField<PVDouble>("value")->put(5.0);
+    pvRecord->getPVStructure()->getSubField<PVInt>("alarm.severity")->put(2);
+    pvRecord->getPVStructure()->getSubField<PVString>("alarm.message")->put("high");
+    pvRecord->lock();
+    pvRecord->process();
+    pvRecord->unlock();
+    testOk1(pvRecord->getPVStructure()->getSubField<PVLong>("timeStamp.secondsPastEpoch")->get()!=0);
+    pvRecord.reset();
+    testOk1(pool->getNumberFree(structure)==1);
+    pvStructure = pool->createPVStructure(structure);
+    testOk1(pvStructure.get()==address);
+    testOk1(pvStructure->getSubField<PVDouble>("value")->get()==0.0);
+    testOk1(pvStructure->getSubField<PVInt>("alarm.severity")->get()==0);
+    testOk1(pvStructure->getSubField<PVString>("alarm.message")->get().empty());
+    testOk1(pvStructure->getSubField<PVLong>("timeStamp.secondsPastEpoch")->get()==0);
+    testOk1(pvStructure->getSubField<PVInt>("timeStamp.nanoseconds")->get()==0);
+    pvRecord = PVRecord::create("poolRecord2",pvStructure);
+    PVRecordFieldPtr pvRecordField =
+        pvRecord->findPVRecordField(pvStructure->getSubField("value"));
+    testOk1(pvRecordField->getFullName()=="poolRecord2.value");
+    testOk1(pvRecordField->getPVRecord()==pvRecord);
+}
+
+static void listenerTest()
+{
+    if(debug) {cout << endl << endl << "****listenerTest****" << endl; }
+    PVRecordPtr pvRecord = createScalar("listenerRecord",pvDouble,"alarm,timeStamp");
+    PVStructurePtr pvStructure = pvRecord->getPVStructure();
+    CountingListenerPtr valueListener(new CountingListener());
+    PVCopyPtr valueCopy = createPVCopy(pvRecord,"value");
+    pvRecord->addListener(valueListener,valueCopy);
+    CountingListenerPtr alarmListener(new CountingListener());
+    PVCopyPtr alarmCopy = createPVCopy(pvRecord,"alarm");
+    pvRecord->addListener(alarmListener,alarmCopy);
+    pvRecord->lock();
+    pvStructure->getSubField<PVDouble>("value")->put(1.0);
+    pvStructure->getSubField<PVInt>("alarm.severity")->put(1);
+    // no listener can see this put
+    pvStructure->getSubField<PVInt>("timeStamp.userTag")->put(1);
+    pvRecord->unlock();
+    testOk1(valueListener->numberFieldPuts==1);
+    testOk1(valueListener->numberParentPuts==0);
+    testOk1(alarmListener->numberFieldPuts==0);
+    // a put below a listened structure goes up to it
+    testOk1(alarmListener->numberParentPuts==1);
+    pvRecord->removeListener(valueListener,valueCopy);
+    pvRecord->lock();
+    pvStructure->getSubField<PVDouble>("value")->put(2.0);
+    pvStructure->getSubField<PVString>("alarm.message")->put("test");
+    pvRecord->unlock();
+    testOk1(valueListener->numberFieldPuts==1);
+    testOk1(alarmListener->numberParentPuts==2);
+    pvRecord->removeListener(alarmListener,alarmCopy);
+    pvRecord->lock();
+    pvStructure->getSubField<PVInt>("alarm.status")->put(1);
+    pvRecord->unlock();
+    testOk1(alarmListener->numberParentPuts==2);
+}
+
+static void bitSetListenerTest()
+{
+    if(debug) {cout << endl << endl << "****bitSetListenerTest****" << endl; }
+    PVRecordPtr pvRecord = createScalar("bitSetRecord",pvDouble,"alarm,timeStamp");
+    PVStructurePtr pvStructure = pvRecord->getPVStructure();
+    CountingListenerPtr listener(new CountingListener(true));
+    PVCopyPtr pvCopy = createPVCopy(pvRecord,"value,alarm");
+    pvRecord->addListener(listener,pvCopy);
+    PVDoublePtr pvValue = pvStructure->getSubField<PVDouble>("value");
+    PVIntPtr pvSeverity = pvStructure->getSubField<PVInt>("alarm.severity");
+    PVIntPtr pvUserTag = pvStructure->getSubField<PVInt>("timeStamp.userTag");
+    pvRecord->lock();
+    pvRecord->beginGroupPut();
+    pvValue->put(1.0);
+    pvSeverity->put(1);
+    pvUserTag->put(1);
+    testOk1(listener->numberBitSetPuts==0);
+    pvRecord->endGroupPut();
+    pvRecord->unlock();
+    // the group put is delivered once, with only the visible fields
+    testOk1(listener->numberBitSetPuts==1);
+    testOk1(listener->numberFieldPuts==0 && listener->numberParentPuts==0);
+    testOk1(listener->changed.cardinality()==2);
+    testOk1(listener->changed.get(pvValue->getFieldOffset()));
+    testOk1(listener->changed.get(pvSeverity->getFieldOffset()));
+    PVStructurePtr copy = pvCopy->createPVStructure();
+    BitSet copyBitSet(copy->getNumberFields());
+    pvCopy->mapMasterBitSet(listener->changed,copyBitSet);
+    testOk1(copyBitSet.cardinality()==2);
+    testOk1(copyBitSet.get(copy->getSubField("value")->getFieldOffset()));
+    testOk1(copyBitSet.get(copy->getSubField("alarm.severity")->getFieldOffset()));
+    // an ancestor of the copied fields maps to all of them
+    BitSet masterBitSet(pvStructure->getNumberFields());
+    masterBitSet.set(0);
+    copyBitSet.clear();
+    pvCopy->mapMasterBitSet(masterBitSet,copyBitSet);
+    testOk1(copyBitSet.get(copy->getSubField("value")->getFieldOffset()));
+    testOk1(copyBitSet.get(copy->getSubField("alarm")->getFieldOffset()));
+    // a put outside a group put is delivered at once
+    pvRecord->lock();
+    pvValue->put(2.0);
+    pvRecord->unlock();
+    testOk1(listener->numberBitSetPuts==2);
+    testOk1(listener->changed.cardinality()==1);
+    pvRecord->removeListener(listener,pvCopy);
+}
+
+class CoalesceRecord;
+typedef std::tr1::shared_ptr<CoalesceRecord> CoalesceRecordPtr;
+
+class CoalesceRecord : public PVRecord
+{
+public:
+    POINTER_DEFINITIONS(CoalesceRecord);
+    static CoalesceRecordPtr create(string const & recordName)
+    {
+        PVStructurePtr pvStructure = getStandardPVField()->scalar(pvDouble,"timeStamp");
+        CoalesceRecordPtr pvRecord(new CoalesceRecord(recordName,pvStructure));
+        pvRecord->initPVRecord();
+        return pvRecord;
+    }
+    virtual void process()
+    {
+        epicsThreadSleep(.002);
+        ++numberProcess;
+        ++threadProcess[epicsThreadGetIdSelf()];
+        if(fail) throw std::runtime_error("process failed");
+    }
+    // the number of processes done by the calling thread
+    int getThreadProcess()
+    {
+        epicsGuard<PVRecord> guard(*this);
+        return threadProcess[epicsThreadGetIdSelf()];
+    }
+    int numberProcess;
+    bool fail;
+private:
+    CoalesceRecord(string const & recordName,PVStructurePtr const & pvStructure)
+    : PVRecord(recordName,pvStructure),
+      numberProcess(0),
+      fail(false)
+    {}
+    std::map<epicsThreadId,int> threadProcess;
+};
+
+class ProcessCaller :
+    public epicsThreadRunable
+{
+public:
+    ProcessCaller(CoalesceRecordPtr const & pvRecord,int numberCalls)
+    : pvRecord(pvRecord),
+      numberCalls(numberCalls),
+      maxPerCall(0),
+      thread(*this,"processCaller",
+          epicsThreadGetStackSize(epicsThreadStackSmall),
+          epicsThreadPriorityLow)
+    {
+        thread.start();
+    }
+    virtual void run()
+    {
+        for(int i=0; i<numberCalls; ++i) {
+            int before = pvRecord->getThreadProcess();
+            pvRecord->processGroupPut();
+            int number = pvRecord->getThreadProcess() - before;
+            if(number>maxPerCall) maxPerCall = number;
+        }
+        done.signal();
+    }
+    bool wait() { return done.wait(30.0);}
+    CoalesceRecordPtr pvRecord;
+    int numberCalls;
+    int maxPerCall;
+private:
+    Event done;
+    epicsThread thread;
+};
+
+static void coalesceTest()
+{
+    if(debug) {cout << endl << endl << "****coalesceTest****" << endl; }
+    CoalesceRecordPtr pvRecord = CoalesceRecord::create("coalesceRecord");
+    pvRecord->processGroupPut();
+    testOk1(pvRecord->numberProcess==1);
+    pvRecord->setCoalesceProcess(true);
+    pvRecord->processGroupPut();
+    testOk1(pvRecord->numberProcess==2);
+    const int numberCallers = 4;
+    const int numberCalls = 20;
+    std::vector<std::tr1::shared_ptr<ProcessCaller> > callers;
+    for(int i=0; i<numberCallers; ++i) {
+        callers.push_back(std::tr1::shared_ptr<ProcessCaller>(
+            new ProcessCaller(pvRecord,numberCalls)));
+    }
+    bool done = true;
+    int maxPerCall = 0;
+    for(int i=0; i<numberCallers; ++i) {
+        if(!callers[i]->wait()) done = false;
+        if(callers[i]->maxPerCall>maxPerCall) maxPerCall = callers[i]->maxPerCall;
+    }
+    testOk1(done);
+    // callers that overlap share processes
+    testOk1(pvRecord->numberProcess<2 + numberCallers*numberCalls);
+    // under steady load no caller does more than its own process and one follow-up
+    testOk1(maxPerCall<=2);
+    pvRecord->fail = true;
+    bool thrown = false;
+    try {
+        pvRecord->processGroupPut();
+    } catch(std::runtime_error & ex) {
+        thrown = (string(ex.what())=="process failed");
+    }
+    testOk1(thrown);
+    pvRecord->fail = false;
+    // a failed process does not leave the record marked as processing
+    pvRecord->processGroupPut();
+    testOk1(pvRecord->getThreadProcess()==4);
+}
+
 MAIN(testPVRecord)
 {
-    testPlan(3);
+    testPlan(41);
     scalarTest();
     arrayTest();
     powerSupplyTest();
+    poolTest();
+    listenerTest();
+    bitSetListenerTest();
+    coalesceTest();
     return 0;
 }
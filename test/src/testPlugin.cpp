@@ -145,6 +145,38 @@ static void arrayTest()
     testOk1(nset==1);
 }
 
+static void subArrayTest()
+{
+    if(debug) {cout << endl << endl << "****subArrayTest****" << endl;}
+    PVStructurePtr pvRecordStructure(getStandardPVField()->scalarArray(pvDouble,""));
+    PVRecordPtr pvRecord(PVRecord::create("subArrayRecord",pvRecordStructure));
+    PVStructurePtr pvRequest(CreateRequest::create()->createRequest("value[array=2:4]"));
+    PVCopyPtr pvCopy(PVCopy::create(pvRecordStructure,pvRequest,""));
+    PVStructurePtr pvStructureCopy(pvCopy->createPVStructure());
+    BitSetPtr bitSet(new BitSet(pvStructureCopy->getNumberFields()));
+    PVDoubleArrayPtr pvValue(pvRecordStructure->getSubField<PVDoubleArray>("value"));
+    PVDoubleArrayPtr pvCopyValue(pvStructureCopy->getSubField<PVDoubleArray>("value"));
+    shared_vector<double> values(10);
+    for(size_t i=0; i<values.size(); i++) values[i] = i + .5;
+    pvValue->replace(freeze(values));
+    pvCopy->updateCopySetBitSet(pvStructureCopy,bitSet);
+    PVDoubleArray::const_svector delivered(pvCopyValue->view());
+    testOk1(delivered.size()==3);
+    testOk1(delivered[0]==2.5 && delivered[1]==3.5 && delivered[2]==4.5);
+    // the sub array is a slice of the record buffer
+    testOk1(delivered.data()==pvValue->view().data() + 2);
+    // replacing the record value leaves the delivered slice unchanged
+    values = shared_vector<double>(10);
+    for(size_t i=0; i<values.size(); i++) values[i] = i + 100.5;
+    pvValue->replace(freeze(values));
+    testOk1(delivered[0]==2.5 && delivered[2]==4.5);
+    bitSet->clear();
+    pvCopy->updateCopySetBitSet(pvStructureCopy,bitSet);
+    PVDoubleArray::const_svector updated(pvCopyValue->view());
+    testOk1(updated.size()==3 && updated[0]==102.5 && updated[2]==104.5);
+    testOk1(delivered[0]==2.5 && delivered[2]==4.5);
+}
+
 static void unionArrayTest()
 {
     if(debug) {cout << endl << endl << "****unionArrayTest****" << endl;}
@@ -334,10 +366,11 @@ static void ignoreTest()
 
 MAIN(testPlugin)
 {
-    testPlan(26);
+    testPlan(32);
     PVDatabasePtr pvDatabase(PVDatabase::getMaster());
     deadbandTest();
     arrayTest();
+    subArrayTest();
     unionArrayTest();
     timeStampTest();
     ignoreTest();
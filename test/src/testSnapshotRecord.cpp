@@ -0,0 +1,146 @@
+/*testSnapshotRecord.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * EPICS pvData is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+/**
+ * @author mrk
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <cstddef>
+#include <string>
+#include <iostream>
+
+#include <epicsThread.h>
+
+#include <pv/standardPVField.h>
+#include <pv/pvData.h>
+#include <pv/event.h>
+#include <pv/pvDatabase.h>
+#include <pv/snapshotRecord.h>
+
+using namespace std;
+using namespace epics::pvData;
+using namespace epics::pvDatabase;
+
+static bool debug = false;
+
+static PVRecordPtr addScalar(string const & recordName,double value)
+{
+    PVStructurePtr pvStructure = getStandardPVField()->scalar(pvDouble,"alarm,timeStamp");
+    pvStructure->getSubField<PVDouble>("value")->put(value);
+    PVRecordPtr pvRecord(PVRecord::create(recordName,pvStructure));
+    PVDatabase::getMaster()->addRecord(pvRecord);
+    return pvRecord;
+}
+
+static void processSnapshot(
+    SnapshotRecordPtr const & snapshot,
+    string const & pattern,
+    string const & fieldName = "value")
+{
+    PVStructurePtr pvStructure = snapshot->getPVStructure();
+    epicsGuard<PVRecord> guard(*snapshot);
+    pvStructure->getSubField<PVString>("argument.pattern")->put(pattern);
+    pvStructure->getSubField<PVString>("argument.fieldName")->put(fieldName);
+    snapshot->beginGroupPut();
+    snapshot->process();
+    snapshot->endGroupPut();
+}
+
+static size_t numberNames(SnapshotRecordPtr const & snapshot)
+{
+    epicsGuard<PVRecord> guard(*snapshot);
+    return snapshot->getPVStructure()->getSubField<PVStringArray>("result.names")->getLength();
+}
+
+static void patternTest()
+{
+    if(debug) {cout << endl << endl << "****patternTest****" << endl; }
+    PVDatabasePtr master = PVDatabase::getMaster();
+    PVRecordPtr first = addScalar("snapA1",1.0);
+    addScalar("snapA2",2.0);
+    SnapshotRecordPtr snapshot = SnapshotRecord::create("snapshotA");
+    testOk1(master->addRecord(snapshot));
+    processSnapshot(snapshot,"snapA*");
+    testOk1(numberNames(snapshot)==2);
+    {
+        epicsGuard<PVRecord> guard(*snapshot);
+        PVStructurePtr pvStructure = snapshot->getPVStructure();
+        PVDoubleArray::const_svector values =
+            pvStructure->getSubField<PVDoubleArray>("result.values")->view();
+        testOk1(values.size()==2 && values[0]==1.0 && values[1]==2.0);
+        testOk1(pvStructure->getSubField<PVString>("result.status")->get()=="success");
+    }
+    // a record added after the first snapshot is found
+    addScalar("snapA3",3.0);
+    processSnapshot(snapshot,"snapA*");
+    testOk1(numberNames(snapshot)==3);
+    master->removeRecord(first);
+    processSnapshot(snapshot,"snapA*");
+    testOk1(numberNames(snapshot)==2);
+    // an explicit name that is added later is also found
+    processSnapshot(snapshot,"snapA2,snapA4");
+    testOk1(numberNames(snapshot)==1);
+    addScalar("snapA4",4.0);
+    processSnapshot(snapshot,"snapA2,snapA4");
+    testOk1(numberNames(snapshot)==2);
+    SnapshotRecord::Snapshot result;
+    testOk1(SnapshotRecord::takeSnapshot("snapA*","value",result).empty());
+    testOk1(result.names.size()==3);
+}
+
+class SnapshotProcessor :
+    public epicsThreadRunable
+{
+public:
+    SnapshotProcessor(SnapshotRecordPtr const & snapshot,string const & pattern)
+    : snapshot(snapshot),
+      pattern(pattern),
+      thread(*this,"snapshotProcessor",
+          epicsThreadGetStackSize(epicsThreadStackSmall),
+          epicsThreadPriorityLow)
+    {
+        thread.start();
+    }
+    virtual void run()
+    {
+        for(int i=0; i<1000; ++i) processSnapshot(snapshot,pattern,"timeStamp.nanoseconds");
+        done.signal();
+    }
+    bool wait() { return done.wait(30.0);}
+private:
+    SnapshotRecordPtr snapshot;
+    string pattern;
+    epics::pvData::Event done;
+    epicsThread thread;
+};
+
+static void crossTest()
+{
+    if(debug) {cout << endl << endl << "****crossTest****" << endl; }
+    // two snapshots of each other, processed at the same time, must not deadlock
+    PVDatabasePtr master = PVDatabase::getMaster();
+    SnapshotRecordPtr first = SnapshotRecord::create("snapshotB1");
+    SnapshotRecordPtr second = SnapshotRecord::create("snapshotB2");
+    master->addRecord(first);
+    master->addRecord(second);
+    SnapshotProcessor firstProcessor(first,"snapshotB2");
+    SnapshotProcessor secondProcessor(second,"snapshotB1");
+    testOk1(firstProcessor.wait());
+    testOk1(secondProcessor.wait());
+    testOk1(numberNames(first)==1);
+    testOk1(numberNames(second)==1);
+}
+
+MAIN(testSnapshotRecord)
+{
+    testPlan(14);
+    patternTest();
+    crossTest();
+    return 0;
+}